@@ -14,7 +14,7 @@ namespace PhysicsEngine
 			: DynamicActor(pose)
 		{
 			// sf of hard polyeurethene, df of hard polyerethene, c.o.r est. based on hard plastic ball (0.688) - domino is not hollow.
-			PxMaterial* polyeurethene = PhysicsEngine::CreateMaterial(0.3f, .1f, 0.4f);
+			PxMaterial* polyeurethene = PhysicsEngine::SharedMaterial(0.3f, .1f, 0.4f);
 			CreateShape(PxBoxGeometry(PxVec3(0.005f, 0.0254f, .0127f)), 1.f, polyeurethene);
 		}
 	};
@@ -26,30 +26,27 @@ namespace PhysicsEngine
 			: DynamicActor(pose)
 		{
 			// sf wood on concrete, df est. wood on concrete, c.o.r est. based on hard wooden ball (0.605) - pallet is weathered, less resilient, and flatter.
-			PxMaterial* wood_on_concrete = PhysicsEngine::CreateMaterial(.62f, .35f, 0.2f);
+			PxMaterial* wood_on_concrete = PhysicsEngine::SharedMaterial(.62f, .35f, 0.2f);
 			PxVec3 plank = PxVec3(.402f, 0.0127f, 0.0508f);
-			PxShape* shape;
+			std::vector<PxTransform> poses;
 			int top = 6;
 			int support = 3;
 
 			for (int i = 0; i < top; i++) {
-				CreateShape(PxBoxGeometry(plank), 1.f, wood_on_concrete);
-				shape = GetShape(i);
-				shape->setLocalPose(PxTransform(PxVec3(0.f, 0.f, i * .1425f)));
+				poses.push_back(PxTransform(PxVec3(0.f, 0.f, i * .1425f)));
 			}
 
 			for (int i = 0; i < support; i++) {
-				CreateShape(PxBoxGeometry(plank), 1.f, wood_on_concrete);
-				shape = GetShape(top + i);
-				shape->setLocalPose(PxTransform(PxVec3(-.39f + (i * .39f), -.0625f, .355f), PxQuat(1.5708f, PxVec3(.0f, 1.0f, .0f)) * PxQuat(1.5708f, PxVec3(1.f, .0f, .0f))));
+				poses.push_back(PxTransform(PxVec3(-.39f + (i * .39f), -.0625f, .355f), PxQuat(1.5708f, PxVec3(.0f, 1.0f, .0f)) * PxQuat(1.5708f, PxVec3(1.f, .0f, .0f))));
 			}
 
 			for (int i = 0; i < 3; i++) {
-				CreateShape(PxBoxGeometry(plank), 1.f, wood_on_concrete);
-				shape = GetShape(top + support + i);
-				shape->setLocalPose(PxTransform(PxVec3(.0f, -.125f, i * .35f)));
+				poses.push_back(PxTransform(PxVec3(.0f, -.125f, i * .35f)));
 			}
 
+			// all planks share the same geometry, mass is computed once all of them are in place
+			CreateShapes(std::vector<PxGeometryHolder>(poses.size(), PxBoxGeometry(plank)), poses, 1.f, wood_on_concrete);
+
 			this->Color(PxVec3(194.f / 255.f, 172.f / 255.f, 122.f / 255.f)); // pale grey-brown
 
 		}
@@ -75,20 +72,16 @@ namespace PhysicsEngine
 				PxVec3(3.f, 40.f, 1.f) * scale,
 			};
 
-			PxConvexMeshDesc mesh_desc;
-			mesh_desc.points.count = (PxU32)leg.size();
-			mesh_desc.points.stride = sizeof(PxVec3);
-			mesh_desc.points.data = &leg.front();
-			mesh_desc.flags = PxConvexFlag::eCOMPUTE_CONVEX;
-			mesh_desc.vertexLimit = 256;
+			// all four legs share a single cooked mesh
+			PxConvexMesh* leg_mesh = ConvexMesh::CookMesh(leg);
 
 			PxShape* shape_placehold;
 
 			// create legs
-			CreateShape(PxConvexMeshGeometry(ConvexMesh::CookMesh(mesh_desc)), 1.f);
-			CreateShape(PxConvexMeshGeometry(ConvexMesh::CookMesh(mesh_desc)), 1.f);
-			CreateShape(PxConvexMeshGeometry(ConvexMesh::CookMesh(mesh_desc)), 1.f);
-			CreateShape(PxConvexMeshGeometry(ConvexMesh::CookMesh(mesh_desc)), 1.f);
+			CreateShape(PxConvexMeshGeometry(leg_mesh), 1.f);
+			CreateShape(PxConvexMeshGeometry(leg_mesh), 1.f);
+			CreateShape(PxConvexMeshGeometry(leg_mesh), 1.f);
+			CreateShape(PxConvexMeshGeometry(leg_mesh), 1.f);
 
 			// position legs
 			shape_placehold = GetShape(0); // far left
@@ -167,7 +160,7 @@ namespace PhysicsEngine
 			};
 
 			// sf of wood on concrete, df of wood, c.o.r est. based on wooden ball - Fan is long and thin therefore much of bounce would be absorbed.
-			PxMaterial* wood = PhysicsEngine::CreateMaterial(.62f, .35f, 0.2f);
+			PxMaterial* wood = PhysicsEngine::SharedMaterial(.62f, .35f, 0.2f);
 
 			PxShape* shape;
 			for (int i = 0; i < 4; i++)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "PhysicsEngine.h"
+#include "MeshCache.h"
 #include <iostream>
 #include <iomanip>
 
@@ -80,6 +81,18 @@ namespace PhysicsEngine
 		//constructor
 		ConvexMesh(const std::vector<PxVec3>& verts, const PxTransform& pose=PxTransform(PxIdentity), PxReal density=1.f)
 			: DynamicActor(pose)
+		{
+			CreateShape(PxConvexMeshGeometry(CookMesh(verts)), density);
+		}
+
+		//mesh cooking (preparation), identical meshes are cooked only once
+		static PxConvexMesh* CookMesh(const PxConvexMeshDesc& mesh_desc)
+		{
+			return MeshCache::Convex(mesh_desc);
+		}
+
+		//cook the convex hull of the vertices
+		static PxConvexMesh* CookMesh(const std::vector<PxVec3>& verts)
 		{
 			PxConvexMeshDesc mesh_desc;
 			mesh_desc.points.count = (PxU32)verts.size();
@@ -88,20 +101,7 @@ namespace PhysicsEngine
 			mesh_desc.flags = PxConvexFlag::eCOMPUTE_CONVEX;
 			mesh_desc.vertexLimit = 256;
 
-			CreateShape(PxConvexMeshGeometry(CookMesh(mesh_desc)), density);
-		}
-
-		//mesh cooking (preparation)
-		static PxConvexMesh* CookMesh(const PxConvexMeshDesc& mesh_desc)
-		{
-			PxDefaultMemoryOutputStream stream;
-
-			if(!GetCooking()->cookConvexMesh(mesh_desc, stream))
-				throw new Exception("ConvexMesh::CookMesh, cooking failed.");
-
-			PxDefaultMemoryInputData input(stream.getData(), stream.getSize());
-
-			return GetPhysics()->createConvexMesh(input);
+			return CookMesh(mesh_desc);
 		}
 	};
 
@@ -124,17 +124,29 @@ namespace PhysicsEngine
 			CreateShape(PxTriangleMeshGeometry(CookMesh(mesh_desc)));
 		}
 
-		//mesh cooking (preparation)
-		PxTriangleMesh* CookMesh(const PxTriangleMeshDesc& mesh_desc)
+		//constructor for meshes with up to 65536 vertices, stored with 16 bit indices
+		TriangleMesh(const std::vector<PxVec3>& verts, const std::vector<PxU16>& trigs, const PxTransform& pose=PxTransform(PxIdentity))
+			: StaticActor(pose)
 		{
-			PxDefaultMemoryOutputStream stream;
+			if (verts.size() > 0x10000)
+				throw new Exception("TriangleMesh::TriangleMesh, too many vertices for 16 bit indices.");
 
-			if(!GetCooking()->cookTriangleMesh(mesh_desc, stream))
-				throw new Exception("TriangleMesh::CookMesh, cooking failed.");
+			PxTriangleMeshDesc mesh_desc;
+			mesh_desc.points.count = (PxU32)verts.size();
+			mesh_desc.points.stride = sizeof(PxVec3);
+			mesh_desc.points.data = &verts.front();
+			mesh_desc.triangles.count = (PxU32)trigs.size()/3;
+			mesh_desc.triangles.stride = 3*sizeof(PxU16);
+			mesh_desc.triangles.data = &trigs.front();
+			mesh_desc.flags = PxMeshFlag::e16_BIT_INDICES;
 
-			PxDefaultMemoryInputData input(stream.getData(), stream.getSize());
+			CreateShape(PxTriangleMeshGeometry(CookMesh(mesh_desc)));
+		}
 
-			return GetPhysics()->createTriangleMesh(input);
+		//mesh cooking (preparation), identical meshes are cooked only once
+		static PxTriangleMesh* CookMesh(const PxTriangleMeshDesc& mesh_desc)
+		{
+			return MeshCache::Triangle(mesh_desc);
 		}
 	};
 
@@ -0,0 +1,170 @@
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+#include "GLExtensions.h"
+#include <cstring>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <GL/glx.h>
+#endif
+
+namespace VisualDebugger
+{
+	namespace GLExtensions
+	{
+		GenBuffersProc glGenBuffers = 0;
+		DeleteBuffersProc glDeleteBuffers = 0;
+		BindBufferProc glBindBuffer = 0;
+		BufferDataProc glBufferData = 0;
+		BufferSubDataProc glBufferSubData = 0;
+		GenFramebuffersProc glGenFramebuffers = 0;
+		DeleteFramebuffersProc glDeleteFramebuffers = 0;
+		BindFramebufferProc glBindFramebuffer = 0;
+		FramebufferTexture2DProc glFramebufferTexture2D = 0;
+		CheckFramebufferStatusProc glCheckFramebufferStatus = 0;
+		ActiveTextureProc glActiveTexture = 0;
+		SwapIntervalProc swap_interval = 0;
+
+		bool vertex_buffers = false;
+		bool shadow_maps = false;
+		bool vertex_array_bgra = false;
+
+		//find an entry point of the current context
+		void* GetProc(const char* name)
+		{
+#ifdef _WIN32
+			void* proc = (void*)wglGetProcAddress(name);
+			//some drivers return small error codes instead of null
+			if ((proc == (void*)1) || (proc == (void*)2) || (proc == (void*)3) || (proc == (void*)-1))
+				return 0;
+			return proc;
+#else
+			return (void*)glXGetProcAddressARB((const GLubyte*)name);
+#endif
+		}
+
+		//find a core entry point, or its ARB version on older drivers
+		void* GetProc(const char* name, const char* arb_name)
+		{
+			void* proc = GetProc(name);
+			if (!proc)
+				proc = GetProc(arb_name);
+			return proc;
+		}
+
+		//version of the current context, e.g. 15 for 1.5
+		int Version()
+		{
+			const char* version = (const char*)glGetString(GL_VERSION);
+			if (!version)
+				return 0;
+			int major = atoi(version);
+			const char* dot = strchr(version, '.');
+			int minor = dot ? atoi(dot + 1) : 0;
+			return major * 10 + minor;
+		}
+
+		bool HasExtension(const char* name)
+		{
+			const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+			if (!extensions)
+				return false;
+
+			//match whole names only
+			size_t length = strlen(name);
+			for (const char* found = strstr(extensions, name); found; found = strstr(found + length, name))
+			{
+				if (((found == extensions) || (found[-1] == ' ')) && ((found[length] == ' ') || (found[length] == 0)))
+					return true;
+			}
+			return false;
+		}
+
+		void Init()
+		{
+			if ((Version() >= 15) || HasExtension("GL_ARB_vertex_buffer_object"))
+			{
+				glGenBuffers = (GenBuffersProc)GetProc("glGenBuffers", "glGenBuffersARB");
+				glDeleteBuffers = (DeleteBuffersProc)GetProc("glDeleteBuffers", "glDeleteBuffersARB");
+				glBindBuffer = (BindBufferProc)GetProc("glBindBuffer", "glBindBufferARB");
+				glBufferData = (BufferDataProc)GetProc("glBufferData", "glBufferDataARB");
+				glBufferSubData = (BufferSubDataProc)GetProc("glBufferSubData", "glBufferSubDataARB");
+			}
+
+			vertex_buffers = glGenBuffers && glDeleteBuffers && glBindBuffer && glBufferData && glBufferSubData;
+
+			//the EXT entry points take the same enums as the core ones
+			if ((Version() >= 30) || HasExtension("GL_ARB_framebuffer_object"))
+			{
+				glGenFramebuffers = (GenFramebuffersProc)GetProc("glGenFramebuffers");
+				glDeleteFramebuffers = (DeleteFramebuffersProc)GetProc("glDeleteFramebuffers");
+				glBindFramebuffer = (BindFramebufferProc)GetProc("glBindFramebuffer");
+				glFramebufferTexture2D = (FramebufferTexture2DProc)GetProc("glFramebufferTexture2D");
+				glCheckFramebufferStatus = (CheckFramebufferStatusProc)GetProc("glCheckFramebufferStatus");
+			}
+			else if (HasExtension("GL_EXT_framebuffer_object"))
+			{
+				glGenFramebuffers = (GenFramebuffersProc)GetProc("glGenFramebuffersEXT");
+				glDeleteFramebuffers = (DeleteFramebuffersProc)GetProc("glDeleteFramebuffersEXT");
+				glBindFramebuffer = (BindFramebufferProc)GetProc("glBindFramebufferEXT");
+				glFramebufferTexture2D = (FramebufferTexture2DProc)GetProc("glFramebufferTexture2DEXT");
+				glCheckFramebufferStatus = (CheckFramebufferStatusProc)GetProc("glCheckFramebufferStatusEXT");
+			}
+
+			bool framebuffers = glGenFramebuffers && glDeleteFramebuffers && glBindFramebuffer && glFramebufferTexture2D && glCheckFramebufferStatus;
+			bool depth_compare = (Version() >= 14) || (HasExtension("GL_ARB_depth_texture") && HasExtension("GL_ARB_shadow"));
+			bool combiners = (Version() >= 13) || HasExtension("GL_ARB_texture_env_combine");
+
+			//shadow receivers use two texture units
+			GLint texture_units = 1;
+			if ((Version() >= 13) || HasExtension("GL_ARB_multitexture"))
+			{
+				glActiveTexture = (ActiveTextureProc)GetProc("glActiveTexture", "glActiveTextureARB");
+				glGetIntegerv(GL_MAX_TEXTURE_UNITS, &texture_units);
+			}
+
+			shadow_maps = framebuffers && depth_compare && combiners && glActiveTexture && (texture_units >= 2);
+
+#ifdef _WIN32
+			swap_interval = (SwapIntervalProc)GetProc("wglSwapIntervalEXT");
+#else
+			//the SGI version cannot turn vsync off
+			swap_interval = (SwapIntervalProc)GetProc("glXSwapIntervalMESA");
+			if (!swap_interval)
+				swap_interval = (SwapIntervalProc)GetProc("glXSwapIntervalSGI");
+#endif
+
+			vertex_array_bgra = (Version() >= 32) || HasExtension("GL_ARB_vertex_array_bgra") || HasExtension("GL_EXT_vertex_array_bgra");
+		}
+
+		bool HasVertexBuffers()
+		{
+			return vertex_buffers;
+		}
+
+		bool HasShadowMaps()
+		{
+			return shadow_maps;
+		}
+
+		bool SwapInterval(int interval)
+		{
+			if (!swap_interval)
+				return false;
+#ifdef _WIN32
+			return swap_interval(interval) != 0;
+#else
+			//GLX reports success as 0
+			return swap_interval(interval) == 0;
+#endif
+		}
+
+		bool HasVertexArrayBGRA()
+		{
+			return vertex_array_bgra;
+		}
+	}
+}
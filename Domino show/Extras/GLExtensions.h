@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <GL/glut.h>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_STREAM_DRAW 0x88E0
+#define GL_STATIC_DRAW 0x88E4
+#define GL_DYNAMIC_DRAW 0x88E8
+#endif
+
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER 0x8D40
+#define GL_DEPTH_ATTACHMENT 0x8D00
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#endif
+
+#ifndef GL_DEPTH_COMPONENT24
+#define GL_DEPTH_COMPONENT24 0x81A6
+#endif
+
+#ifndef GL_BGRA
+#define GL_BGRA 0x80E1
+#endif
+
+#ifndef GL_CLAMP_TO_BORDER
+#define GL_CLAMP_TO_BORDER 0x812D
+#endif
+
+#ifndef GL_TEXTURE_COMPARE_MODE
+#define GL_TEXTURE_COMPARE_MODE 0x884C
+#define GL_TEXTURE_COMPARE_FUNC 0x884D
+#define GL_COMPARE_R_TO_TEXTURE 0x884E
+#define GL_DEPTH_TEXTURE_MODE 0x884B
+#endif
+
+#ifndef GL_COMBINE
+#define GL_COMBINE 0x8570
+#define GL_COMBINE_RGB 0x8571
+#define GL_COMBINE_ALPHA 0x8572
+#define GL_INTERPOLATE 0x8575
+#define GL_CONSTANT 0x8576
+#define GL_PRIMARY_COLOR 0x8577
+#define GL_SOURCE0_RGB 0x8580
+#define GL_SOURCE1_RGB 0x8581
+#define GL_SOURCE2_RGB 0x8582
+#define GL_SOURCE0_ALPHA 0x8588
+#define GL_OPERAND0_RGB 0x8590
+#define GL_OPERAND1_RGB 0x8591
+#define GL_OPERAND2_RGB 0x8592
+#endif
+
+#ifndef GL_TEXTURE0
+#define GL_TEXTURE0 0x84C0
+#define GL_TEXTURE1 0x84C1
+#define GL_MAX_TEXTURE_UNITS 0x84E2
+#endif
+
+#ifndef GL_PREVIOUS
+#define GL_PREVIOUS 0x8578
+#endif
+
+namespace VisualDebugger
+{
+	///OpenGL entry points above version 1.1, loaded at run time.
+	///Every group of functions is optional: check its availability before use and keep a GL 1.1 fallback.
+	namespace GLExtensions
+	{
+		typedef void (APIENTRY *GenBuffersProc)(GLsizei n, GLuint* buffers);
+		typedef void (APIENTRY *DeleteBuffersProc)(GLsizei n, const GLuint* buffers);
+		typedef void (APIENTRY *BindBufferProc)(GLenum target, GLuint buffer);
+		typedef void (APIENTRY *BufferDataProc)(GLenum target, ptrdiff_t size, const void* data, GLenum usage);
+		typedef void (APIENTRY *BufferSubDataProc)(GLenum target, ptrdiff_t offset, ptrdiff_t size, const void* data);
+		typedef void (APIENTRY *GenFramebuffersProc)(GLsizei n, GLuint* framebuffers);
+		typedef void (APIENTRY *DeleteFramebuffersProc)(GLsizei n, const GLuint* framebuffers);
+		typedef void (APIENTRY *BindFramebufferProc)(GLenum target, GLuint framebuffer);
+		typedef void (APIENTRY *FramebufferTexture2DProc)(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+		typedef GLenum (APIENTRY *CheckFramebufferStatusProc)(GLenum target);
+		typedef int (APIENTRY *SwapIntervalProc)(int interval);
+		typedef void (APIENTRY *ActiveTextureProc)(GLenum texture);
+
+		///Vertex buffer objects (GL 1.5 or ARB_vertex_buffer_object)
+		extern GenBuffersProc glGenBuffers;
+		extern DeleteBuffersProc glDeleteBuffers;
+		extern BindBufferProc glBindBuffer;
+		extern BufferDataProc glBufferData;
+		extern BufferSubDataProc glBufferSubData;
+
+		///Framebuffer objects (GL 3.0 or EXT_framebuffer_object)
+		extern GenFramebuffersProc glGenFramebuffers;
+		extern DeleteFramebuffersProc glDeleteFramebuffers;
+		extern BindFramebufferProc glBindFramebuffer;
+		extern FramebufferTexture2DProc glFramebufferTexture2D;
+		extern CheckFramebufferStatusProc glCheckFramebufferStatus;
+
+		///Multitexturing (GL 1.3 or ARB_multitexture), part of the shadow maps
+		extern ActiveTextureProc glActiveTexture;
+
+		///Load all entry points, needs a current GL context
+		void Init();
+
+		///Are vertex buffer objects available
+		bool HasVertexBuffers();
+
+		///Are framebuffer objects, depth textures with comparison, two texture units and texture combiners available
+		bool HasShadowMaps();
+
+		///Can vertex colours be given as BGRA bytes (GL 3.2 or ARB/EXT_vertex_array_bgra)
+		bool HasVertexArrayBGRA();
+
+		///Set the number of vertical retraces a buffer swap waits for (0 = no vsync),
+		///returns false if the driver does not let the application choose (WGL_EXT_swap_control or GLX_MESA/SGI_swap_control)
+		bool SwapInterval(int interval);
+
+		///Is the extension listed by the driver
+		bool HasExtension(const char* name);
+	}
+}
@@ -11,6 +11,7 @@ unsigned int GLFontRenderer::m_textureObject=0;
 int GLFontRenderer::m_screenWidth=640;
 int GLFontRenderer::m_screenHeight=480;
 float GLFontRenderer::m_color[4]={1.0f, 1.0f, 1.0f, 1.0f};
+std::vector<GLFontVertex> GLFontRenderer::m_scratch;
 
 bool GLFontRenderer::init()
 {
@@ -37,18 +38,91 @@ bool GLFontRenderer::init()
 }
 
 void GLFontRenderer::print(float x, float y, float fontSize, const char* pString, bool forceMonoSpace, int monoSpaceWidth, bool doOrthoProj)
+{
+	m_scratch.clear();
+	build(m_scratch, x, y, fontSize, pString, forceMonoSpace, monoSpaceWidth);
+	if(!m_scratch.empty())
+		draw(&m_scratch[0], (unsigned int)m_scratch.size(), doOrthoProj);
+}
+
+void GLFontRenderer::build(std::vector<GLFontVertex>& vertices, float x, float y, float fontSize, const char* pString, bool forceMonoSpace, int monoSpaceWidth)
 {
 	x = x*m_screenWidth;
 	y = y*m_screenHeight;
 	fontSize = fontSize*m_screenHeight;
 
+	unsigned char color[4];
+	for(int i=0;i<4;i++)
+	{
+		float channel = m_color[i] < 0.0f ? 0.0f : (m_color[i] > 1.0f ? 1.0f : m_color[i]);
+		color[i] = (unsigned char)(channel*255.0f);
+	}
+
+	const float glyphHeightUV = ((float)OGL_FONT_CHARS_PER_COL)/OGL_FONT_TEXTURE_HEIGHT*2-0.01f;
+	const float glyphWidthUV = ((float)OGL_FONT_CHARS_PER_ROW)/OGL_FONT_TEXTURE_WIDTH;
+
+	float translate = 0.0f;
+	float translateDown = 0.0f;
+
+	unsigned int num = (unsigned int)strlen(pString);
+	vertices.reserve(vertices.size()+num*6);
+
+	for(unsigned int i=0;i<num; i++)
+	{
+		if (pString[i] == '\n') {
+			translateDown-=0.005f*m_screenHeight+fontSize;
+			translate = 0.0f;
+			continue;
+		}
+
+		int c = pString[i]-OGL_FONT_CHAR_BASE;
+		if (c < OGL_FONT_CHARS_PER_ROW*OGL_FONT_CHARS_PER_COL) {
+
+			float glyphWidth = (float)GLFontGlyphWidth[c];
+			if(forceMonoSpace){
+				glyphWidth = (float)monoSpaceWidth;
+			}
+			
+			glyphWidth = glyphWidth*(fontSize/(((float)OGL_FONT_TEXTURE_WIDTH)/OGL_FONT_CHARS_PER_ROW))-0.01f;
+
+			float cxUV = float((c)%OGL_FONT_CHARS_PER_ROW)/OGL_FONT_CHARS_PER_ROW+0.008f;
+			float cyUV = float((c)/OGL_FONT_CHARS_PER_ROW)/OGL_FONT_CHARS_PER_COL+0.008f;
+
+			// two triangles: bottom left, top right, top left and bottom left, bottom right, top right
+			const float corners[6][4] = {
+				{ 0, 0, cxUV, cyUV+glyphHeightUV },
+				{ fontSize, fontSize, cxUV+glyphWidthUV, cyUV },
+				{ 0, fontSize, cxUV, cyUV },
+				{ 0, 0, cxUV, cyUV+glyphHeightUV },
+				{ fontSize, 0, cxUV+glyphWidthUV, cyUV+glyphHeightUV },
+				{ fontSize, fontSize, cxUV+glyphWidthUV, cyUV }
+			};
+
+			for(int k=0;k<6;k++)
+			{
+				GLFontVertex vertex;
+				vertex.x = x+corners[k][0]+translate;
+				vertex.y = y+corners[k][1]+translateDown;
+				vertex.z = 0;
+				vertex.u = corners[k][2];
+				vertex.v = corners[k][3];
+				memcpy(vertex.color, color, sizeof(color));
+				vertices.push_back(vertex);
+			}
+
+			translate+=glyphWidth;
+		}
+	}
+}
+
+void GLFontRenderer::draw(const GLFontVertex* pVertices, unsigned int count, bool doOrthoProj)
+{
 	if(!m_isInit)
 	{
 		m_isInit = init();
 	}
 
-	unsigned int num = (unsigned int)strlen(pString);
-	if(m_isInit && num > 0)
+	if(m_isInit && count > 0)
 	{
 		glBlendFunc(GL_SRC_ALPHA,GL_ONE_MINUS_SRC_ALPHA);
 		glDisable(GL_DEPTH_TEST);
@@ -71,96 +145,17 @@ void GLFontRenderer::print(float x, float y, float fontSize, const char* pString
 
 		glEnable(GL_BLEND);
 
-		glColor4f(m_color[0], m_color[1], m_color[2], m_color[3]);
-
-		const float glyphHeightUV = ((float)OGL_FONT_CHARS_PER_COL)/OGL_FONT_TEXTURE_HEIGHT*2-0.01f;
-
-		float translate = 0.0f;
-
-		float* pVertList = new float[num*3*6];
-    	float* pTextureCoordList = new float[num*2*6];
-		int vertIndex = 0;
-    	int textureCoordIndex = 0;
-
-		float translateDown = 0.0f;
-		unsigned int count = 0;
-
-		for(unsigned int i=0;i<num; i++)
-		{
-			const float glyphWidthUV = ((float)OGL_FONT_CHARS_PER_ROW)/OGL_FONT_TEXTURE_WIDTH;
-
-			if (pString[i] == '\n') {
-				translateDown-=0.005f*m_screenHeight+fontSize;
-				translate = 0.0f;
-				continue;
-			}
-
-			int c = pString[i]-OGL_FONT_CHAR_BASE;
-			if (c < OGL_FONT_CHARS_PER_ROW*OGL_FONT_CHARS_PER_COL) {
-
-				count++;
-
-				float glyphWidth = (float)GLFontGlyphWidth[c];
-				if(forceMonoSpace){
-					glyphWidth = (float)monoSpaceWidth;
-				}
-				
-				glyphWidth = glyphWidth*(fontSize/(((float)OGL_FONT_TEXTURE_WIDTH)/OGL_FONT_CHARS_PER_ROW))-0.01f;
-
-				float cxUV = float((c)%OGL_FONT_CHARS_PER_ROW)/OGL_FONT_CHARS_PER_ROW+0.008f;
-				float cyUV = float((c)/OGL_FONT_CHARS_PER_ROW)/OGL_FONT_CHARS_PER_COL+0.008f;
-
-				pTextureCoordList[textureCoordIndex++] = cxUV;
-				pTextureCoordList[textureCoordIndex++] = cyUV+glyphHeightUV;
-				pVertList[vertIndex++] = x+0+translate;
-				pVertList[vertIndex++] = y+0+translateDown;
-				pVertList[vertIndex++] = 0;
-
-				pTextureCoordList[textureCoordIndex++] = cxUV+glyphWidthUV;
-				pTextureCoordList[textureCoordIndex++] = cyUV;
-				pVertList[vertIndex++] = x+fontSize+translate;
-				pVertList[vertIndex++] = y+fontSize+translateDown;
-				pVertList[vertIndex++] = 0;
-
-				pTextureCoordList[textureCoordIndex++] = cxUV;
-				pTextureCoordList[textureCoordIndex++] = cyUV;
-				pVertList[vertIndex++] = x+0+translate;
-				pVertList[vertIndex++] = y+fontSize+translateDown;
-				pVertList[vertIndex++] = 0;
-
-				pTextureCoordList[textureCoordIndex++] = cxUV;
-				pTextureCoordList[textureCoordIndex++] = cyUV+glyphHeightUV;
-				pVertList[vertIndex++] = x+0+translate;
-				pVertList[vertIndex++] = y+0+translateDown;
-				pVertList[vertIndex++] = 0;
-
-				pTextureCoordList[textureCoordIndex++] = cxUV+glyphWidthUV;
-				pTextureCoordList[textureCoordIndex++] = cyUV+glyphHeightUV;
-				pVertList[vertIndex++] = x+fontSize+translate;
-				pVertList[vertIndex++] = y+0+translateDown;
-				pVertList[vertIndex++] = 0;
-
-				pTextureCoordList[textureCoordIndex++] = cxUV+glyphWidthUV;
-				pTextureCoordList[textureCoordIndex++] = cyUV;
-				pVertList[vertIndex++] = x+fontSize+translate;
-				pVertList[vertIndex++] = y+fontSize+translateDown;
-				pVertList[vertIndex++] = 0;
-
-				translate+=glyphWidth;
-			}
-		}
-
 		glEnableClientState(GL_VERTEX_ARRAY);
-		glVertexPointer(3, GL_FLOAT, 0, pVertList);
+		glVertexPointer(3, GL_FLOAT, sizeof(GLFontVertex), &pVertices->x);
 		glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-		glTexCoordPointer(2, GL_FLOAT, 0, pTextureCoordList);
-		glDrawArrays(GL_TRIANGLES, 0, count*6);
+		glTexCoordPointer(2, GL_FLOAT, sizeof(GLFontVertex), &pVertices->u);
+		glEnableClientState(GL_COLOR_ARRAY);
+		glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(GLFontVertex), pVertices->color);
+		glDrawArrays(GL_TRIANGLES, 0, count);
+		glDisableClientState(GL_COLOR_ARRAY);
 		glDisableClientState(GL_TEXTURE_COORD_ARRAY);
 		glDisableClientState(GL_VERTEX_ARRAY);
 
-		delete[] pVertList;
-		delete[] pTextureCoordList;
-
 		if(doOrthoProj)
 		{
 			glMatrixMode(GL_PROJECTION);
@@ -9,6 +9,15 @@
 #ifndef __GL_FONT_RENDERER__
 #define __GL_FONT_RENDERER__
 
+#include <vector>
+
+// screen space vertex of a glyph quad with its colour
+struct GLFontVertex{
+	float x, y, z;
+	float u, v;
+	unsigned char color[4];
+};
+
 class GLFontRenderer{
 	
 private:
@@ -18,6 +27,8 @@ private:
 	static int m_screenWidth;
 	static int m_screenHeight;
 	static float m_color[4];
+	// vertices of a single print call
+	static std::vector<GLFontVertex> m_scratch;
 
 public:
 	
@@ -25,6 +36,11 @@ public:
 	static void print(float x, float y, float fontSize, const char* pString, bool forceMonoSpace=false, int monoSpaceWidth=11, bool doOrthoProj=true);
 	static void setScreenResolution(int screenWidth, int screenHeight);
 	static void setColor(float r, float g, float b, float a);
+
+	// append the glyphs of a string to a vertex list, using the current resolution and colour
+	static void build(std::vector<GLFontVertex>& vertices, float x, float y, float fontSize, const char* pString, bool forceMonoSpace=false, int monoSpaceWidth=11);
+	// draw a vertex list with a single call
+	static void draw(const GLFontVertex* pVertices, unsigned int count, bool doOrthoProj=true);
 	
 };
 
@@ -12,6 +12,12 @@ namespace VisualDebugger
 	class HUDScreen
 	{
 		vector<string> content;
+		//glyphs of all lines, rebuilt when the text, font, colour or window size change
+		vector<GLFontVertex> mesh;
+		bool mesh_dirty;
+		PxReal mesh_font_size;
+		PxVec3 mesh_color;
+		int mesh_width, mesh_height;
 
 	public:
 		int id;
@@ -19,7 +25,7 @@ namespace VisualDebugger
 		PxVec3 color;
 
 		HUDScreen(int screen_id, const PxVec3& _color=PxVec3(1.f,1.f,1.f), const PxReal& _font_size=0.024f) :
-			id(screen_id), color(_color), font_size(_font_size)
+			id(screen_id), color(_color), font_size(_font_size), mesh_dirty(true), mesh_width(0), mesh_height(0)
 		{
 		}
 
@@ -27,19 +33,51 @@ namespace VisualDebugger
 		void AddLine(string line)
 		{
 			content.push_back(line);
+			mesh_dirty = true;
 		}
 
-		///Render the screen
+		///Replace a single line of text, reuses the memory of the old line
+		void SetLine(unsigned int index, const char* line)
+		{
+			if (index >= content.size())
+				content.resize(index + 1);
+			if (content[index] != line)
+			{
+				content[index].assign(line);
+				mesh_dirty = true;
+			}
+		}
+
+		///Render the screen with a single draw call
 		void Render()
 		{
-			for (unsigned int i = 0; i < content.size(); i++)
-				Renderer::RenderText(content[i], PxVec2(0.0, 1.f-(i+1)*font_size), color, font_size);
+			int width = glutGet(GLUT_WINDOW_WIDTH);
+			int height = glutGet(GLUT_WINDOW_HEIGHT);
+			GLFontRenderer::setScreenResolution(width, height);
+
+			if (mesh_dirty || (mesh_font_size != font_size) || (mesh_color != color) || (mesh_width != width) || (mesh_height != height))
+			{
+				mesh.clear();
+				GLFontRenderer::setColor(color.x, color.y, color.z, 1.f);
+				for (unsigned int i = 0; i < content.size(); i++)
+					GLFontRenderer::build(mesh, 0.f, 1.f-(i+1)*font_size, font_size, content[i].c_str());
+
+				mesh_dirty = false;
+				mesh_font_size = font_size;
+				mesh_color = color;
+				mesh_width = width;
+				mesh_height = height;
+			}
+
+			if (mesh.size())
+				GLFontRenderer::draw(&mesh.front(), (unsigned int)mesh.size());
 		}
 
 		///Clear content of the screen
 		void Clear()
 		{
 			content.clear();
+			mesh_dirty = true;
 		}
 	};
 
@@ -72,6 +110,22 @@ namespace VisualDebugger
 			screens.back()->AddLine(line);
 		}
 
+		///Replace a single line of a specific screen
+		void SetLine(int screen_id, unsigned int index, const char* line)
+		{
+			for (unsigned int i = 0; i < screens.size(); i++)
+			{
+				if (screens[i]->id == screen_id)
+				{
+					screens[i]->SetLine(index, line);
+					return;
+				}
+			}
+
+			screens.push_back(new HUDScreen(screen_id));
+			screens.back()->SetLine(index, line);
+		}
+
 		///Set the active screen
 		void ActiveScreen(int value)
 		{
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "PxPhysicsAPI.h"
+#include <vector>
+
+///An immutable copy of everything the renderer needs from a scene.
+///The scene publishes a new snapshot after each step, the renderer never touches PhysX objects.
+///Data is stored as parallel arrays: one entry per rigid shape and one entry per cloth.
+class RenderSnapshot
+{
+public:
+	//shape identifiers, used to match entries between two snapshots (never dereferenced by the renderer)
+	std::vector<const physx::PxShape*> shapes;
+	//world transformation of each shape
+	std::vector<physx::PxTransform> poses;
+	//geometry of each shape
+	std::vector<physx::PxGeometryHolder> geometries;
+	//colour of each shape
+	std::vector<physx::PxVec3> colors;
+	//world bounds of each shape, used for culling
+	std::vector<physx::PxBounds3> bounds;
+
+	//world transformation of each cloth
+	std::vector<physx::PxTransform> cloth_poses;
+	//colour of each cloth
+	std::vector<physx::PxVec3> cloth_colors;
+	//mesh (quads) of each cloth
+	std::vector<const physx::PxClothMeshDesc*> cloth_meshes;
+	//first particle of each cloth in the particle array
+	std::vector<physx::PxU32> cloth_first_particle;
+	//number of particles of each cloth
+	std::vector<physx::PxU32> cloth_particle_count;
+	//particle positions of all cloths, in the cloth local space
+	std::vector<physx::PxVec3> particles;
+
+	///Remove all entries, keeping the allocated memory
+	void Clear()
+	{
+		shapes.clear();
+		poses.clear();
+		geometries.clear();
+		colors.clear();
+		bounds.clear();
+		ClearCloths();
+	}
+
+	///Remove the cloth entries only
+	void ClearCloths()
+	{
+		cloth_poses.clear();
+		cloth_colors.clear();
+		cloth_meshes.clear();
+		cloth_first_particle.clear();
+		cloth_particle_count.clear();
+		particles.clear();
+	}
+};
@@ -1,7 +1,11 @@
 #include "Renderer.h"
+#include "GLExtensions.h"
 #include <iostream>
 #include <vector>
-#include "UserData.h"
+#include <unordered_map>
+#include <mutex>
+#include <cstddef>
+#include <cstring>
 
 using namespace std;
 
@@ -13,6 +17,13 @@ namespace VisualDebugger
 		PxVec3 background_color = PxVec3(0.f,0.f,0.f);
 		int render_detail = 10;
 		bool show_shadows = true;
+		int shadow_map_size = 2048;
+		//region covered by the shadow map
+		PxVec3 shadow_center = PxVec3(0.f, 0.f, 0.f);
+		PxReal shadow_radius = 50.f;
+
+		//homogeneous world space position of GL_LIGHT0, shadows are cast along its direction
+		static const PxReal light_position[] = { 25.f, 25.f, 100.f, 5.f };
 
 		static float gPlaneData[]={
 			-1.f, 0.f, -1.f, 0.f, 1.f, 0.f, -1.f, 0.f, 1.f, 0.f, 1.f, 0.f,
@@ -20,105 +31,440 @@ namespace VisualDebugger
 			1.f, 0.f, 1.f, 0.f, 1.f, 0.f, 1.f, 0.f, -1.f, 0.f, 1.f, 0.f
 		};
 
-		void DrawPlane()
+		//shadows are projected onto the ground plane along this direction
+		static const PxVec3 shadow_dir(-0.7071067f, -0.7071067f, -0.7071067f);
+		static const PxReal shadow_matrix[]={ 1,0,0,0, -shadow_dir.x/shadow_dir.y,0,-shadow_dir.z/shadow_dir.y,0, 0,0,1,0, 0,0,0,1 };
+		//colour of shadowed surfaces relative to their lit colour
+		static const PxReal shadow_factor = .9f;
+
+		///Vertex of a shape template: unit size, local space
+		struct TemplateVertex
 		{
-			glScalef(10240,0,10240);
-			glEnableClientState(GL_VERTEX_ARRAY);
-			glEnableClientState(GL_NORMAL_ARRAY);
-			glVertexPointer(3, GL_FLOAT, 2*3*sizeof(float), gPlaneData);
-			glNormalPointer(GL_FLOAT, 2*3*sizeof(float), gPlaneData+3);
-			glDrawArrays(GL_TRIANGLES, 0, 6);
-			glDisableClientState(GL_VERTEX_ARRAY);
-			glDisableClientState(GL_NORMAL_ARRAY);
-		}
+			PxVec3 position;
+			PxVec3 normal;
+		};
 
-		void DrawSphere(const PxGeometryHolder& geometry)
+		///Vertex of the batched shapes: world space, packed colour
+		struct BatchVertex
 		{
-			glutSolidSphere(geometry.sphere().radius, render_detail, render_detail);
-		}
+			PxVec3 position;
+			PxVec3 normal;
+			GLubyte color[4];
+		};
 
-		void DrawBox(const PxGeometryHolder& geometry)
+		//number of tessellation levels of spheres and capsules, each level halves the detail
+		static const PxU32 LOD_COUNT = 4;
+		//coarsest tessellation of any level
+		static const int LOD_MIN_DETAIL = 4;
+		//target length of a silhouette segment on screen
+		static const PxReal LOD_PIXELS_PER_SEGMENT = 8.f;
+
+		//box from -1 to 1, unit spheres and unit cylinders (along x from -1 to 1) at each level, as triangle lists
+		static std::vector<TemplateVertex> box_template;
+		static std::vector<TemplateVertex> sphere_templates[LOD_COUNT];
+		static std::vector<TemplateVertex> cylinder_templates[LOD_COUNT];
+		//tessellation of each level and render_detail it was built for
+		static int lod_details[LOD_COUNT];
+		static int lod_render_detail = 0;
+
+		//camera position, direction, aspect ratio and screen pixels per unit at distance 1, set by Start
+		static PxVec3 camera_eye(0.f);
+		static PxVec3 camera_dir(0.f, 0.f, -1.f);
+		static PxReal camera_aspect = 1.f;
+		static PxReal pixels_per_unit = 1.f;
+
+		//all visible boxes, spheres, capsules and convex meshes of the frame, kept between frames to avoid allocations
+		static std::vector<BatchVertex> batch;
+		//batched shapes outside of the view, only built for a depth pass or planar shadows that need them
+		static std::vector<BatchVertex> culled_batch;
+
+		//planes of the view frustum (normal and distance, pointing inwards), set by Start
+		static PxVec4 frustum[6];
+
+		///Vertex of the debug data with the colour as RGBA bytes.
+		///Points, lines and triangles of PhysX are sequences of the same layout with the colour as 0xAARRGGBB.
+		struct DebugVertex
 		{
-			PxVec3 half_size = geometry.box().halfExtents;
-			glScalef(half_size.x, half_size.y, half_size.z);
-			glutSolidCube(2.f);		
-		}
+			PxVec3 position;
+			GLubyte color[4];
+		};
+
+		static_assert(sizeof(PxDebugPoint) == sizeof(DebugVertex), "Debug points are not 16 byte vertices");
+		static_assert(sizeof(PxDebugLine) == 2*sizeof(DebugVertex), "Debug lines are not pairs of 16 byte vertices");
+		static_assert(sizeof(PxDebugTriangle) == 3*sizeof(DebugVertex), "Debug triangles are not triples of 16 byte vertices");
 
-		void DrawCapsule(const PxGeometryHolder& geometry)
+		//debug data with swizzled colours, only used without BGRA vertex colours
+		static std::vector<DebugVertex> debug_vertices;
+		//streaming buffer of the debug data, 0 without vertex buffer objects
+		static GLuint debug_buffer = 0;
+		static size_t debug_buffer_size = 0;
+
+		///Convex or triangle mesh, triangulated once.
+		///Triangle meshes are kept on the GPU when possible, convex meshes are templates of the batch like the primitives.
+		struct MeshBuffers
 		{
-			const PxF32 radius = geometry.capsule().radius;
-			const PxF32 halfHeight = geometry.capsule().halfHeight;
+			//vertex buffer object, 0 when not available
+			GLuint vertex_buffer;
+			//triangle list, client side copy only kept for convex meshes or without vertex buffer objects
+			std::vector<TemplateVertex> vertices;
+			GLsizei vertex_count;
 
-			//Sphere
-			glPushMatrix();
-			glTranslatef(halfHeight,0.f, 0.f);
-			glutSolidSphere(radius, render_detail, render_detail);		
-			glPopMatrix();
+			MeshBuffers() : vertex_buffer(0), vertex_count(0) {}
+		};
 
-			//Sphere
-			glPushMatrix();
-			glTranslatef(-halfHeight,0.f,0.f);
-			glutSolidSphere(radius, render_detail, render_detail);		
-			glPopMatrix();
+		//triangulated meshes, keyed by the PhysX mesh
+		static std::unordered_map<const void*, MeshBuffers> mesh_buffers;
 
-			//Cylinder
-			glPushMatrix();
-			glTranslatef(-halfHeight,0.f,0.f);
-			glRotatef(90.f,0.f,1.f,0.f);
+		///Collects the meshes freed by PhysX, which can happen on any thread.
+		///The buffers are released by the renderer on the next frame.
+		class MeshDeletionListener : public PxDeletionListener
+		{
+		public:
+			std::mutex lock;
+			std::vector<const void*> released;
 
-			GLUquadric* qobj = gluNewQuadric();
-			gluQuadricNormals(qobj, GLU_SMOOTH);
-			gluCylinder(qobj, radius, radius, halfHeight*2.f, render_detail, render_detail);
-			gluDeleteQuadric(qobj);
-			glPopMatrix();
+			virtual void onRelease(const PxBase* observed, void* userData, PxDeletionEventFlag::Enum deletionEvent)
+			{
+				const void* mesh = observed->is<PxConvexMesh>();
+				if (!mesh)
+					mesh = observed->is<PxTriangleMesh>();
+				if (!mesh)
+					return;
+
+				std::lock_guard<std::mutex> guard(lock);
+				released.push_back(mesh);
+			}
+		};
+
+		static MeshDeletionListener deletion_listener;
+
+		void DeleteMeshBuffers(MeshBuffers& buffers)
+		{
+			if (buffers.vertex_buffer)
+				GLExtensions::glDeleteBuffers(1, &buffers.vertex_buffer);
 		}
 
-		void DrawConvexMesh(const PxGeometryHolder& geometry)
+		//drop the buffers of meshes released since the last frame
+		void PurgeReleasedMeshes()
+		{
+			std::vector<const void*> released;
+			{
+				std::lock_guard<std::mutex> guard(deletion_listener.lock);
+				released.swap(deletion_listener.released);
+			}
+
+			for (PxU32 i = 0; i < released.size(); i++)
+			{
+				std::unordered_map<const void*, MeshBuffers>::iterator it = mesh_buffers.find(released[i]);
+				if (it != mesh_buffers.end())
+				{
+					DeleteMeshBuffers(it->second);
+					mesh_buffers.erase(it);
+				}
+			}
+		}
+
+		//flat shaded triangle list, polygons as triangle fans
+		void TriangulateConvexMesh(const PxConvexMesh* mesh, MeshBuffers& buffers)
 		{
-			PxConvexMesh* mesh = geometry.convexMesh().convexMesh;
-			PxU32 num_polys = mesh->getNbPolygons();
 			const PxVec3* verts = mesh->getVertices();
 			const PxU8* indicies = mesh->getIndexBuffer();
 
-			for (PxU32 i = 0; i < num_polys; i++)
+			for (PxU32 i = 0; i < mesh->getNbPolygons(); i++)
 			{
 				PxHullPolygon face;
-				if (mesh->getPolygonData(i,face))
+				if (!mesh->getPolygonData(i, face))
+					continue;
+
+				PxVec3 normal(face.mPlane[0], face.mPlane[1], face.mPlane[2]);
+				const PxU8* faceIdx = indicies + face.mIndexBase;
+				for (PxU32 j = 1; j + 1 < face.mNbVerts; j++)
 				{
-					glBegin(GL_POLYGON);
-					glNormal3f(face.mPlane[0],face.mPlane[1],face.mPlane[2]);
-					const PxU8* faceIdx = indicies + face.mIndexBase;
-					for (PxU32 j = 0; j < face.mNbVerts; j++)
-					{
-						PxVec3 v = verts[faceIdx[j]];
-						glVertex3f(v.x,v.y,v.z);
-					}
-					glEnd();
+					TemplateVertex vertex0 = { verts[faceIdx[0]], normal }, vertex1 = { verts[faceIdx[j]], normal }, vertex2 = { verts[faceIdx[j+1]], normal };
+					buffers.vertices.push_back(vertex0);
+					buffers.vertices.push_back(vertex1);
+					buffers.vertices.push_back(vertex2);
 				}
 			}
 		}
 
-		void DrawTriangleMesh(const PxGeometryHolder& geometry)
+		//flat shaded triangle list, one vertex per triangle corner
+		void TriangulateTriangleMesh(const PxTriangleMesh* mesh, MeshBuffers& buffers)
 		{
-			PxTriangleMesh* mesh = geometry.triangleMesh().triangleMesh;
 			const PxVec3* verts = mesh->getVertices();
-			PxU16* trigs = (PxU16*)mesh->getTriangles();
 			const PxU32 num_trigs = mesh->getNbTriangles();
 
+			//indices are stored as 16 bit values when the mesh is small enough
+#if PX_PHYSICS_VERSION < 0x304000 // SDK 3.3
+			bool short_indices = mesh->getTriangleMeshFlags() & PxTriangleMeshFlag::eHAS_16BIT_TRIANGLE_INDICES;
+#else
+			bool short_indices = mesh->getTriangleMeshFlags() & PxTriangleMeshFlag::e16_BIT_INDICES;
+#endif
+			const PxU16* trigs16 = (const PxU16*)mesh->getTriangles();
+			const PxU32* trigs32 = (const PxU32*)mesh->getTriangles();
+
+			buffers.vertices.reserve(num_trigs*3);
+
 			for (PxU32 i = 0; i < num_trigs*3; i+=3)
 			{
-				PxVec3 v0 = verts[trigs[i]];
-				PxVec3 v1 = verts[trigs[i+1]];
-				PxVec3 v2 = verts[trigs[i+2]];
+				PxVec3 v0 = verts[short_indices ? trigs16[i] : trigs32[i]];
+				PxVec3 v1 = verts[short_indices ? trigs16[i+1] : trigs32[i+1]];
+				PxVec3 v2 = verts[short_indices ? trigs16[i+2] : trigs32[i+2]];
 				PxVec3 n = (v1-v0).cross(v2-v0);
 				n.normalize();
-				glBegin(GL_POLYGON);
-				glNormal3f(n.x, n.y, n.z);
-				glVertex3f(v0.x, v0.y, v0.z);
-				glVertex3f(v1.x, v1.y, v1.z);
-				glVertex3f(v2.x, v2.y, v2.z);
-				glEnd();
+
+				TemplateVertex vertex0 = { v0, n }, vertex1 = { v1, n }, vertex2 = { v2, n };
+				buffers.vertices.push_back(vertex0);
+				buffers.vertices.push_back(vertex1);
+				buffers.vertices.push_back(vertex2);
+			}
+		}
+
+		//upload data into a new static buffer object
+		GLuint UploadBuffer(GLenum target, const void* data, size_t size)
+		{
+			GLuint buffer;
+			GLExtensions::glGenBuffers(1, &buffer);
+			GLExtensions::glBindBuffer(target, buffer);
+			GLExtensions::glBufferData(target, size, data, GL_STATIC_DRAW);
+			GLExtensions::glBindBuffer(target, 0);
+			return buffer;
+		}
+
+		//get the buffers of a mesh, triangulate and upload it on first use
+		MeshBuffers& GetMeshBuffers(const PxGeometryHolder& geometry)
+		{
+			const void* key;
+			if (geometry.getType() == PxGeometryType::eCONVEXMESH)
+				key = geometry.convexMesh().convexMesh;
+			else
+				key = geometry.triangleMesh().triangleMesh;
+
+			std::unordered_map<const void*, MeshBuffers>::iterator it = mesh_buffers.find(key);
+			if (it != mesh_buffers.end())
+				return it->second;
+
+			MeshBuffers& buffers = mesh_buffers[key];
+			if (geometry.getType() == PxGeometryType::eCONVEXMESH)
+				TriangulateConvexMesh(geometry.convexMesh().convexMesh, buffers);
+			else
+				TriangulateTriangleMesh(geometry.triangleMesh().triangleMesh, buffers);
+
+			buffers.vertex_count = (GLsizei)buffers.vertices.size();
+
+			//convex meshes are transformed into the batch on the CPU and need their triangles there
+			if (GLExtensions::HasVertexBuffers() && buffers.vertex_count && (geometry.getType() != PxGeometryType::eCONVEXMESH))
+			{
+				buffers.vertex_buffer = UploadBuffer(GL_ARRAY_BUFFER, &buffers.vertices.front(), buffers.vertices.size() * sizeof(TemplateVertex));
+
+				//the GPU has its own copy now
+				std::vector<TemplateVertex>().swap(buffers.vertices);
+			}
+
+			return buffers;
+		}
+
+		void DrawMesh(const PxGeometryHolder& geometry)
+		{
+			MeshBuffers& buffers = GetMeshBuffers(geometry);
+			if (!buffers.vertex_count)
+				return;
+
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glEnableClientState(GL_NORMAL_ARRAY);
+
+			if (buffers.vertex_buffer)
+			{
+				GLExtensions::glBindBuffer(GL_ARRAY_BUFFER, buffers.vertex_buffer);
+				glVertexPointer(3, GL_FLOAT, sizeof(TemplateVertex), (const GLvoid*)offsetof(TemplateVertex, position));
+				glNormalPointer(GL_FLOAT, sizeof(TemplateVertex), (const GLvoid*)offsetof(TemplateVertex, normal));
+				glDrawArrays(GL_TRIANGLES, 0, buffers.vertex_count);
+				GLExtensions::glBindBuffer(GL_ARRAY_BUFFER, 0);
+			}
+			else
+			{
+				glVertexPointer(3, GL_FLOAT, sizeof(TemplateVertex), &buffers.vertices.front().position);
+				glNormalPointer(GL_FLOAT, sizeof(TemplateVertex), &buffers.vertices.front().normal);
+				glDrawArrays(GL_TRIANGLES, 0, buffers.vertex_count);
 			}
+
+			glDisableClientState(GL_NORMAL_ARRAY);
+			glDisableClientState(GL_VERTEX_ARRAY);
+		}
+
+		void BuildBoxTemplate()
+		{
+			box_template.clear();
+			for (PxU32 axis = 0; axis < 3; axis++)
+			{
+				for (PxReal sign = -1.f; sign <= 1.f; sign += 2.f)
+				{
+					PxVec3 n(0.f), u(0.f), v(0.f);
+					n[axis] = sign;
+					u[(axis + 1) % 3] = 1.f;
+					v[(axis + 2) % 3] = 1.f;
+
+					PxVec3 corners[4] = { n - u - v, n + u - v, n + u + v, n - u + v };
+					const PxU32 order[6] = { 0, 1, 2, 0, 2, 3 };
+					for (PxU32 i = 0; i < 6; i++)
+					{
+						TemplateVertex vertex = { corners[order[i]], n };
+						box_template.push_back(vertex);
+					}
+				}
+			}
+		}
+
+		void BuildSphereTemplate(std::vector<TemplateVertex>& sphere_template, int detail)
+		{
+			sphere_template.clear();
+
+			PxU32 stacks = (PxU32)PxMax(detail, 2);
+			PxU32 slices = (PxU32)PxMax(detail, 3);
+
+			for (PxU32 i = 0; i < stacks; i++)
+			{
+				PxReal theta0 = PxPi * i / stacks;
+				PxReal theta1 = PxPi * (i + 1) / stacks;
+				for (PxU32 j = 0; j < slices; j++)
+				{
+					PxReal phi0 = PxTwoPi * j / slices;
+					PxReal phi1 = PxTwoPi * (j + 1) / slices;
+
+					PxVec3 corners[4] = {
+						PxVec3(PxSin(theta0)*PxCos(phi0), PxCos(theta0), PxSin(theta0)*PxSin(phi0)),
+						PxVec3(PxSin(theta1)*PxCos(phi0), PxCos(theta1), PxSin(theta1)*PxSin(phi0)),
+						PxVec3(PxSin(theta1)*PxCos(phi1), PxCos(theta1), PxSin(theta1)*PxSin(phi1)),
+						PxVec3(PxSin(theta0)*PxCos(phi1), PxCos(theta0), PxSin(theta0)*PxSin(phi1))
+					};
+					const PxU32 order[6] = { 0, 1, 2, 0, 2, 3 };
+					for (PxU32 k = 0; k < 6; k++)
+					{
+						//unit sphere: the normal is the position
+						TemplateVertex vertex = { corners[order[k]], corners[order[k]] };
+						sphere_template.push_back(vertex);
+					}
+				}
+			}
+		}
+
+		//side of a cylinder, the caps are covered by the spheres of a capsule
+		void BuildCylinderTemplate(std::vector<TemplateVertex>& cylinder_template, int detail)
+		{
+			cylinder_template.clear();
+
+			PxU32 slices = (PxU32)PxMax(detail, 3);
+
+			for (PxU32 j = 0; j < slices; j++)
+			{
+				PxReal phi0 = PxTwoPi * j / slices;
+				PxReal phi1 = PxTwoPi * (j + 1) / slices;
+
+				PxVec3 n0(0.f, PxCos(phi0), PxSin(phi0));
+				PxVec3 n1(0.f, PxCos(phi1), PxSin(phi1));
+				PxVec3 axis(1.f, 0.f, 0.f);
+
+				TemplateVertex corners[4] = {
+					{ n0 - axis, n0 },
+					{ n0 + axis, n0 },
+					{ n1 + axis, n1 },
+					{ n1 - axis, n1 }
+				};
+				const PxU32 order[6] = { 0, 2, 1, 0, 3, 2 };
+				for (PxU32 k = 0; k < 6; k++)
+					cylinder_template.push_back(corners[order[k]]);
+			}
+		}
+
+		//all levels of detail, the first one uses render_detail
+		void BuildLevelsOfDetail()
+		{
+			lod_render_detail = render_detail;
+			for (PxU32 level = 0; level < LOD_COUNT; level++)
+			{
+				lod_details[level] = PxMax(render_detail >> level, PxMin(render_detail, LOD_MIN_DETAIL));
+				BuildSphereTemplate(sphere_templates[level], lod_details[level]);
+				BuildCylinderTemplate(cylinder_templates[level], lod_details[level]);
+			}
+		}
+
+		//the coarsest level that keeps the silhouette of a round shape smooth on screen
+		PxU32 LevelOfDetail(const PxVec3& center, PxReal radius)
+		{
+			PxReal distance = PxMax((center - camera_eye).magnitude(), 1e-3f);
+			PxReal pixels = radius * pixels_per_unit / distance;
+			PxReal segments = PxTwoPi * pixels / LOD_PIXELS_PER_SEGMENT;
+
+			PxU32 level = 0;
+			while ((level + 1 < LOD_COUNT) && (lod_details[level + 1] >= segments))
+				level++;
+			return level;
+		}
+
+		//transform a template into a batch
+		void AddInstance(std::vector<BatchVertex>& batch, const std::vector<TemplateVertex>& shape_template, const PxTransform& pose, const PxVec3& scale, const PxVec3& color)
+		{
+			GLubyte packed[4] = {
+				(GLubyte)(PxClamp(color.x, 0.f, 1.f) * 255.f),
+				(GLubyte)(PxClamp(color.y, 0.f, 1.f) * 255.f),
+				(GLubyte)(PxClamp(color.z, 0.f, 1.f) * 255.f),
+				255 };
+
+			PxU32 first = (PxU32)batch.size();
+			batch.resize(first + shape_template.size());
+			BatchVertex* out = &batch[first];
+
+			for (PxU32 i = 0; i < shape_template.size(); i++, out++)
+			{
+				out->position = pose.transform(shape_template[i].position.multiply(scale));
+				//scaling is either uniform or along the face normals, so rotating is enough
+				out->normal = pose.rotate(shape_template[i].normal);
+				out->color[0] = packed[0];
+				out->color[1] = packed[1];
+				out->color[2] = packed[2];
+				out->color[3] = packed[3];
+			}
+		}
+
+		//draw all batched shapes with a single call, optionally positions only (shadows and depth)
+		void DrawBatch(const std::vector<BatchVertex>& batch, bool positions_only=false)
+		{
+			if (batch.empty())
+				return;
+
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glVertexPointer(3, GL_FLOAT, sizeof(BatchVertex), &batch.front().position);
+			if (!positions_only)
+			{
+				glEnableClientState(GL_NORMAL_ARRAY);
+				glEnableClientState(GL_COLOR_ARRAY);
+				glNormalPointer(GL_FLOAT, sizeof(BatchVertex), &batch.front().normal);
+				glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(BatchVertex), batch.front().color);
+			}
+			glDrawArrays(GL_TRIANGLES, 0, (GLsizei)batch.size());
+			if (!positions_only)
+			{
+				glDisableClientState(GL_COLOR_ARRAY);
+				glDisableClientState(GL_NORMAL_ARRAY);
+			}
+			glDisableClientState(GL_VERTEX_ARRAY);
+		}
+
+		void DrawPlane()
+		{
+			glScalef(10240,0,10240);
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glEnableClientState(GL_NORMAL_ARRAY);
+			glVertexPointer(3, GL_FLOAT, 2*3*sizeof(float), gPlaneData);
+			glNormalPointer(GL_FLOAT, 2*3*sizeof(float), gPlaneData+3);
+			glDrawArrays(GL_TRIANGLES, 0, 6);
+			glDisableClientState(GL_VERTEX_ARRAY);
+			glDisableClientState(GL_NORMAL_ARRAY);
+		}
+
+		void DrawTriangleMesh(const PxGeometryHolder& geometry)
+		{
+			DrawMesh(geometry);
 		}
 
 		void DrawHeightField(const PxGeometryHolder& geometry)
@@ -126,6 +472,7 @@ namespace VisualDebugger
 			//TODO
 		}
 
+		//boxes, spheres, capsules and convex meshes are never drawn one by one, see Batched
 		void RenderGeometry(const PxGeometryHolder& geometry)
 		{
 			switch(geometry.getType())
@@ -133,18 +480,6 @@ namespace VisualDebugger
 			case PxGeometryType::ePLANE:
 				DrawPlane();
 				break;
-			case PxGeometryType::eSPHERE:
-				DrawSphere(geometry);
-				break;
-			case PxGeometryType::eBOX:			
-				DrawBox(geometry);
-				break;
-			case PxGeometryType::eCAPSULE:
-				DrawCapsule(geometry);
-				break;
-			case PxGeometryType::eCONVEXMESH:
-				DrawConvexMesh(geometry);
-				break;
 			case PxGeometryType::eTRIANGLEMESH:
 				DrawTriangleMesh(geometry);
 				break;
@@ -156,49 +491,118 @@ namespace VisualDebugger
 			}
 		}
 
-		void RenderCloth(const PxCloth* cloth)
+		///Topology and normals of a single cloth, kept between frames
+		struct ClothCache
+		{
+			//quads around each vertex (compressed rows: the quads of vertex i are adjacency[adjacency_start[i]..adjacency_start[i+1]])
+			std::vector<PxU32> adjacency_start;
+			std::vector<PxU32> adjacency;
+			//normal of each quad, recomputed every frame
+			std::vector<PxVec3> face_normals;
+			//normal of each vertex, recomputed every frame
+			std::vector<PxVec3> normals;
+			//quads the topology was built from
+			const PxU32* quads;
+			PxU32 quad_count;
+			//last frame the cloth was drawn
+			PxU32 frame;
+
+			ClothCache() : quads(0), quad_count(0), frame(0) {}
+		};
+
+		//render caches, keyed by the cloth mesh
+		static std::unordered_map<const PxClothMeshDesc*, ClothCache> cloth_caches;
+		//frames rendered so far
+		static PxU32 frame_count = 0;
+		//cloths not drawn for this many frames lose their cache
+		static const PxU32 cloth_cache_frames = 60;
+
+		//build the vertex to quad adjacency of a cloth
+		void BuildClothCache(ClothCache& cache, const PxU32* quads, PxU32 quad_count, PxU32 vert_count)
 		{
-			PxClothMeshDesc* mesh_desc = ((UserData*)cloth->userData)->cloth_mesh_desc;
-			PxVec3* color = ((UserData*)cloth->userData)->color;
+			cache.quads = quads;
+			cache.quad_count = quad_count;
+			cache.face_normals.resize(quad_count);
+			cache.normals.resize(vert_count);
+
+			//count the quads of each vertex, then turn the counts into offsets
+			cache.adjacency_start.assign(vert_count + 1, 0);
+			for (PxU32 i = 0; i < quad_count*4; i++)
+				cache.adjacency_start[quads[i] + 1]++;
+			for (PxU32 i = 0; i < vert_count; i++)
+				cache.adjacency_start[i + 1] += cache.adjacency_start[i];
+
+			cache.adjacency.resize(quad_count*4);
+			std::vector<PxU32> fill(cache.adjacency_start.begin(), cache.adjacency_start.end() - 1);
+			for (PxU32 i = 0; i < quad_count*4; i++)
+				cache.adjacency[fill[quads[i]]++] = i / 4;
+		}
 
+		//get the cache of a cloth, rebuild it if the mesh changed
+		ClothCache& GetClothCache(const PxClothMeshDesc* mesh_desc, PxU32 vert_count)
+		{
+			const PxU32* quads = (const PxU32*)mesh_desc->quads.data;
 			PxU32 quad_count = mesh_desc->quads.count;
-			PxU32* quads = (PxU32*)mesh_desc->quads.data;
 
-			std::vector<PxVec3> verts(cloth->getNbParticles());
-			std::vector<PxVec3> norms(verts.size(), PxVec3(0.f,0.f,0.f));
+			ClothCache& cache = cloth_caches[mesh_desc];
+			if ((cache.quads != quads) || (cache.quad_count != quad_count) || (cache.normals.size() != vert_count))
+				BuildClothCache(cache, quads, quad_count, vert_count);
 
-			//get verts data
-			cloth->lockParticleData();
+			cache.frame = frame_count;
+			return cache;
+		}
 
-			PxClothParticleData* particle_data = cloth->lockParticleData();
-			if (!particle_data)
+		//drop the caches of cloths that are no longer drawn
+		void PurgeClothCaches()
+		{
+			std::unordered_map<const PxClothMeshDesc*, ClothCache>::iterator it = cloth_caches.begin();
+			while (it != cloth_caches.end())
+			{
+				if (frame_count - it->second.frame > cloth_cache_frames)
+					it = cloth_caches.erase(it);
+				else
+					it++;
+			}
+		}
+
+		void RenderCloth(const RenderSnapshot& snapshot, PxU32 index)
+		{
+			const PxClothMeshDesc* mesh_desc = snapshot.cloth_meshes[index];
+			const PxVec3& color = snapshot.cloth_colors[index];
+
+			PxU32 vert_count = snapshot.cloth_particle_count[index];
+			if (!vert_count)
 				return;
-			// copy vertex positions
-			for (PxU32 j = 0; j < verts.size(); j++)
-				verts[j] = particle_data->particles[j].pos;
+			const PxVec3* verts = &snapshot.particles[snapshot.cloth_first_particle[index]];
 
-			particle_data->unlock();
+			ClothCache& cache = GetClothCache(mesh_desc, vert_count);
+			PxU32 quad_count = cache.quad_count;
+			const PxU32* quads = cache.quads;
 
-			for (PxU32 i = 0; i < quad_count*4; i+=4)
+			//face normals in one pass over the quads
+			PxVec3* face_normals = cache.face_normals.data();
+			for (PxU32 i = 0; i < quad_count; i++)
 			{
-				PxVec3 v0 = verts[quads[i]];
-				PxVec3 v1 = verts[quads[i+1]];
-				PxVec3 v2 = verts[quads[i+2]];
-				PxVec3 n = -((v1-v0).cross(v2-v0));
-
-				norms[quads[i]] += n;
-				norms[quads[i+1]] += n;
-				norms[quads[i+2]] += n;
-				norms[quads[i+3]] += n;
+				const PxU32* quad = quads + i*4;
+				PxVec3 v0 = verts[quad[0]];
+				face_normals[i] = -((verts[quad[1]]-v0).cross(verts[quad[2]]-v0));
 			}
 
-			for (PxU32 i = 0; i < norms.size(); i++)
-				norms[i].normalize();
+			//vertex normals in one pass over the vertices, gathering from the adjacent quads
+			const PxU32* adjacency_start = cache.adjacency_start.data();
+			const PxU32* adjacency = cache.adjacency.data();
+			PxVec3* norms = cache.normals.data();
+			for (PxU32 i = 0; i < vert_count; i++)
+			{
+				PxVec3 n(0.f);
+				for (PxU32 j = adjacency_start[i]; j < adjacency_start[i+1]; j++)
+					n += face_normals[adjacency[j]];
+				norms[i] = n.getNormalized();
+			}
 
-			PxTransform pose = cloth->getGlobalPose();
-			PxMat44 shapePose(pose);
+			PxMat44 shapePose(snapshot.cloth_poses[index]);
 
-			glColor4f(color->x, color->y, color->z, 1.f);
+			glColor4f(color.x, color.y, color.z, 1.f);
 
 			glPushMatrix();						
 			glMultMatrixf((float*)&shapePose);
@@ -206,8 +610,8 @@ namespace VisualDebugger
 			glEnableClientState(GL_VERTEX_ARRAY);
 			glEnableClientState(GL_NORMAL_ARRAY);
 
-			glVertexPointer(3, GL_FLOAT, sizeof(PxVec3), &verts.front());
-			glNormalPointer(GL_FLOAT, sizeof(PxVec3), &norms.front());
+			glVertexPointer(3, GL_FLOAT, sizeof(PxVec3), verts);
+			glNormalPointer(GL_FLOAT, sizeof(PxVec3), norms);
 
 			glDrawElements(GL_QUADS, quad_count*4, GL_UNSIGNED_INT, quads);
 
@@ -224,7 +628,6 @@ namespace VisualDebugger
 
 		void idleCallback()
 		{
-			glClearColor(background_color.x, background_color.y, background_color.z, 1.f);
 			glutPostRedisplay();
 		}
 
@@ -248,6 +651,11 @@ namespace VisualDebugger
 
 		void Init()
 		{
+			GLExtensions::Init();
+
+			//meshes are released by PhysX, their buffers follow on the next frame
+			PxGetPhysics().registerDeletionListener(deletion_listener, PxDeletionEventFlag::eMEMORY_RELEASE, false);
+
 			// Setup default render states
 			PxReal specular_material[]	= { .1f, .1f, .1f, 1.f };
 			glEnable(GL_DEPTH_TEST);
@@ -256,19 +664,60 @@ namespace VisualDebugger
 			glMaterialf(GL_FRONT_AND_BACK, GL_SHININESS, .025f);
 			glMaterialfv(GL_FRONT_AND_BACK, GL_SPECULAR, specular_material);
 
+			BuildBoxTemplate();
+			BuildLevelsOfDetail();
+
 			// Setup lighting
 			glEnable(GL_LIGHTING);
 			PxReal ambientColor[]	= { 0.55f, 0.55f, 0.55f, 1.f };
 			PxReal diffuseColor[]	= { .02f, .02f, .02f, .8f };		
-			PxReal position[]		= { 25.f, 25.f, 100.f, 5.f };		
 			glLightfv(GL_LIGHT0, GL_AMBIENT, ambientColor);
 			glLightfv(GL_LIGHT0, GL_DIFFUSE, diffuseColor);
-			glLightfv(GL_LIGHT0, GL_POSITION, position);
 			glEnable(GL_LIGHT0);
 		}
 
+		//frustum planes from the rows of projection * modelview
+		void ExtractFrustum()
+		{
+			GLfloat projection[16], modelview[16];
+			glGetFloatv(GL_PROJECTION_MATRIX, projection);
+			glGetFloatv(GL_MODELVIEW_MATRIX, modelview);
+
+			PxMat44 clip = PxMat44(projection) * PxMat44(modelview);
+			PxVec4 rows[4] = {
+				PxVec4(clip.column0.x, clip.column1.x, clip.column2.x, clip.column3.x),
+				PxVec4(clip.column0.y, clip.column1.y, clip.column2.y, clip.column3.y),
+				PxVec4(clip.column0.z, clip.column1.z, clip.column2.z, clip.column3.z),
+				PxVec4(clip.column0.w, clip.column1.w, clip.column2.w, clip.column3.w)
+			};
+
+			//left, right, bottom, top, near, far
+			for (PxU32 i = 0; i < 3; i++)
+			{
+				frustum[i*2] = rows[3] + rows[i];
+				frustum[i*2+1] = rows[3] - rows[i];
+			}
+		}
+
+		//is any part of the box inside the frustum
+		bool Visible(const PxBounds3& bounds)
+		{
+			for (PxU32 i = 0; i < 6; i++)
+			{
+				const PxVec4& plane = frustum[i];
+				//the corner furthest along the plane normal
+				PxVec3 corner(plane.x > 0.f ? bounds.maximum.x : bounds.minimum.x,
+					plane.y > 0.f ? bounds.maximum.y : bounds.minimum.y,
+					plane.z > 0.f ? bounds.maximum.z : bounds.minimum.z);
+				if (plane.x*corner.x + plane.y*corner.y + plane.z*corner.z + plane.w < 0.f)
+					return false;
+			}
+			return true;
+		}
+
 		void Start(const PxVec3& cameraEye, const PxVec3& cameraDir)
 		{
+			glClearColor(background_color.x, background_color.y, background_color.z, 1.f);
 			glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
 			// Setup camera
@@ -276,9 +725,43 @@ namespace VisualDebugger
 			glLoadIdentity();
 			gluPerspective(60.f, (float)glutGet(GLUT_WINDOW_WIDTH)/(float)glutGet(GLUT_WINDOW_HEIGHT), 1.f, 10000.f);
 
+			//half of the window height covers tan(30 degrees) at distance 1
+			camera_eye = cameraEye;
+			camera_dir = cameraDir.getNormalized();
+			camera_aspect = (float)glutGet(GLUT_WINDOW_WIDTH)/(float)glutGet(GLUT_WINDOW_HEIGHT);
+			pixels_per_unit = (glutGet(GLUT_WINDOW_HEIGHT) * .5f) / PxTan(PxPi / 6.f);
+
 			glMatrixMode(GL_MODELVIEW);
 			glLoadIdentity();
 			gluLookAt(cameraEye.x, cameraEye.y, cameraEye.z, cameraEye.x + cameraDir.x, cameraEye.y + cameraDir.y, cameraEye.z + cameraDir.z, 0.f, 1.f, 0.f);
+
+			//set under the camera view, so the light stays at the same world position as the shadow camera
+			glLightfv(GL_LIGHT0, GL_POSITION, light_position);
+
+			ExtractFrustum();
+		}
+
+		PxBounds3 ViewBounds(PxReal distance)
+		{
+			//looking straight up or down the world y axis cannot define the sides
+			PxVec3 world_up = (PxAbs(camera_dir.y) > .99f) ? PxVec3(0.f, 0.f, 1.f) : PxVec3(0.f, 1.f, 0.f);
+			PxVec3 right = camera_dir.cross(world_up).getNormalized();
+			PxVec3 up = right.cross(camera_dir);
+
+			//corners of the near plane and of the plane at the given distance
+			PxBounds3 bounds = PxBounds3::empty();
+			const PxReal depths[2] = { 1.f, distance };
+			for (PxU32 i = 0; i < 2; i++)
+			{
+				PxVec3 center = camera_eye + camera_dir * depths[i];
+				PxVec3 half_up = up * depths[i] * PxTan(PxPi / 6.f);
+				PxVec3 half_right = right * depths[i] * PxTan(PxPi / 6.f) * camera_aspect;
+				bounds.include(center - half_right - half_up);
+				bounds.include(center + half_right - half_up);
+				bounds.include(center + half_right + half_up);
+				bounds.include(center - half_right + half_up);
+			}
+			return bounds;
 		}
 
 		void BackgroundColor(const PxVec3& color)
@@ -286,83 +769,472 @@ namespace VisualDebugger
 			background_color = color;
 		}
 
-		void Render(PxActor** actors, const PxU32 numActors)
+		//interpolate between two poses, alpha = 0 gives the first one
+		PxTransform Interpolate(const PxTransform& pose0, const PxTransform& pose1, PxReal alpha)
 		{
-			PxVec3 shadow_color = default_color*0.9;
-			for(PxU32 i=0;i<numActors;i++) {
-#if PX_PHYSICS_VERSION < 0x304000 // SDK 3.3
-				if (actors[i]->isCloth()) {
-#else
-				if (actors[i]->is<PxCloth>()) {
-#endif
-					RenderCloth((PxCloth*)actors[i]);
+			//take the shorter way round
+			PxQuat q1 = (pose0.q.dot(pose1.q) < 0.f) ? -pose1.q : pose1.q;
+			PxQuat q = pose0.q*(1.f-alpha) + q1*alpha;
+			return PxTransform(pose0.p*(1.f-alpha) + pose1.p*alpha, q.getNormalized());
+		}
+
+		//shadow map resources, 0 until first used
+		static GLuint shadow_texture = 0;
+		static GLuint shadow_framebuffer = 0;
+		static int shadow_texture_size = 0;
+		//shadow maps are not supported, planar shadows are used instead
+		static bool shadow_map_failed = false;
+		//the shadow map has to be rendered even if nothing moved
+		static bool shadow_map_dirty = true;
+		//light space matrices of the last depth pass
+		static GLfloat light_projection[16];
+		static GLfloat light_view[16];
+		//shape poses of the current frame
+		static std::vector<PxTransform> frame_poses;
+		//visibility of each shape in the current frame
+		static std::vector<bool> frame_visible;
+		//can the shadow of each shape fall into the view in the current frame
+		static std::vector<bool> frame_casts_shadow;
+		//snapshot poses of the last depth pass, before interpolation
+		static std::vector<PxTransform> shadow_poses;
+		//pose changes below these are not redrawn into the shadow map: a millimetre, or a rotation of about 0.15 degrees
+		static const PxReal shadow_position_epsilon = 1e-3f;
+		static const PxReal shadow_rotation_epsilon = 1e-6f;
+
+		void ReleaseShadowMap()
+		{
+			if (shadow_framebuffer)
+				GLExtensions::glDeleteFramebuffers(1, &shadow_framebuffer);
+			if (shadow_texture)
+				glDeleteTextures(1, &shadow_texture);
+			shadow_framebuffer = 0;
+			shadow_texture = 0;
+			shadow_texture_size = 0;
+		}
+
+		//create a depth texture of shadow_map_size and a framebuffer rendering into it
+		bool CreateShadowMap()
+		{
+			ReleaseShadowMap();
+
+			glGenTextures(1, &shadow_texture);
+			glBindTexture(GL_TEXTURE_2D, shadow_texture);
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, shadow_map_size, shadow_map_size, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, 0);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			//everything outside of the shadow region is lit: the border is at the far depth
+			const GLfloat border[4] = { 1.f, 1.f, 1.f, 1.f };
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+			glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, border);
+			//sampling returns 1 for lit and 0 for shadowed fragments
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_R_TO_TEXTURE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+			glTexParameteri(GL_TEXTURE_2D, GL_DEPTH_TEXTURE_MODE, GL_INTENSITY);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			GLExtensions::glGenFramebuffers(1, &shadow_framebuffer);
+			GLExtensions::glBindFramebuffer(GL_FRAMEBUFFER, shadow_framebuffer);
+			GLExtensions::glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, shadow_texture, 0);
+			glDrawBuffer(GL_NONE);
+			glReadBuffer(GL_NONE);
+			GLenum status = GLExtensions::glCheckFramebufferStatus(GL_FRAMEBUFFER);
+			GLExtensions::glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+			if (status != GL_FRAMEBUFFER_COMPLETE)
+			{
+				ReleaseShadowMap();
+				return false;
+			}
+
+			shadow_texture_size = shadow_map_size;
+			shadow_map_dirty = true;
+			return true;
+		}
+
+		//can the shadow map be used this frame, (re)creates it when needed
+		bool UseShadowMap()
+		{
+			if (shadow_map_failed || !GLExtensions::HasShadowMaps())
+				return false;
+
+			if ((shadow_texture_size != shadow_map_size) && !CreateShadowMap())
+			{
+				shadow_map_failed = true;
+				return false;
+			}
+
+			return true;
+		}
+
+		//direction of the light, from the world position of GL_LIGHT0 towards the shadow region
+		PxVec3 LightDirection()
+		{
+			PxVec3 position(light_position[0], light_position[1], light_position[2]);
+			if (light_position[3] != 0.f)
+				return (shadow_center - position / light_position[3]).getNormalized();
+			else
+				return -position.getNormalized();
+		}
+
+		//boxes, spheres, capsules and convex meshes are drawn in a single batch
+		bool Batched(PxGeometryType::Enum type)
+		{
+			return (type == PxGeometryType::eBOX) || (type == PxGeometryType::eSPHERE) || (type == PxGeometryType::eCAPSULE) ||
+				(type == PxGeometryType::eCONVEXMESH);
+		}
+
+		//add a box, sphere, capsule or convex mesh to a batch
+		void AddShape(std::vector<BatchVertex>& target, const PxGeometryHolder& h, const PxTransform& pose, const PxVec3& color)
+		{
+			if (h.getType() == PxGeometryType::eBOX)
+				AddInstance(target, box_template, pose, h.box().halfExtents, color);
+			else if (h.getType() == PxGeometryType::eSPHERE)
+			{
+				PxReal radius = h.sphere().radius;
+				PxU32 level = LevelOfDetail(pose.p, radius);
+				AddInstance(target, sphere_templates[level], pose, PxVec3(radius), color);
+			}
+			else if (h.getType() == PxGeometryType::eCAPSULE)
+			{
+				PxReal radius = h.capsule().radius;
+				PxReal half_height = h.capsule().halfHeight;
+				PxU32 level = LevelOfDetail(pose.p, radius);
+				AddInstance(target, sphere_templates[level], pose * PxTransform(PxVec3(-half_height, 0.f, 0.f)), PxVec3(radius), color);
+				AddInstance(target, sphere_templates[level], pose * PxTransform(PxVec3(half_height, 0.f, 0.f)), PxVec3(radius), color);
+				AddInstance(target, cylinder_templates[level], pose, PxVec3(half_height, radius, radius), color);
+			}
+			else if (h.getType() == PxGeometryType::eCONVEXMESH)
+			{
+				//every shape of the same PxConvexMesh shares one template, the rotation of a mesh scale is not supported
+				const MeshBuffers& buffers = GetMeshBuffers(h);
+				AddInstance(target, buffers.vertices, pose, h.convexMesh().scale.scale, color);
+			}
+		}
+
+		//batch the shapes outside of the view that cast a shadow into it, only done when such shadows are drawn
+		void BuildCulledBatch(const RenderSnapshot& snapshot)
+		{
+			culled_batch.clear();
+			for (PxU32 i = 0; i < snapshot.shapes.size(); i++)
+			{
+				if (!frame_visible[i] && frame_casts_shadow[i] && Batched(snapshot.geometries[i].getType()))
+					AddShape(culled_batch, snapshot.geometries[i], frame_poses[i], snapshot.colors[i]);
+			}
+		}
+
+		//bounds of the planar shadow of a box, projected along shadow_dir onto the ground
+		PxBounds3 ShadowBounds(const PxBounds3& bounds)
+		{
+			PxBounds3 shadow = PxBounds3::empty();
+			for (PxU32 i = 0; i < 8; i++)
+			{
+				PxVec3 corner((i & 1) ? bounds.maximum.x : bounds.minimum.x,
+					(i & 2) ? bounds.maximum.y : bounds.minimum.y,
+					(i & 4) ? bounds.maximum.z : bounds.minimum.z);
+				shadow.include(PxVec3(corner.x - corner.y * shadow_dir.x / shadow_dir.y, 0.f, corner.z - corner.y * shadow_dir.z / shadow_dir.y));
+			}
+			return shadow;
+		}
+
+		//draw the shapes that are not batched and then the batch, depth_only skips planes, colours and lighting changes
+		void DrawShapes(const RenderSnapshot& snapshot, bool depth_only)
+		{
+			for (PxU32 i = 0; i < snapshot.shapes.size(); i++)
+			{
+				const PxGeometryHolder& h = snapshot.geometries[i];
+				PxGeometryType::Enum type = h.getType();
+
+				if (Batched(type))
+					continue;
+				if (depth_only && (type == PxGeometryType::ePLANE))
+					continue;
+				//everything casts shadows, only visible shapes are drawn
+				if (!depth_only && !frame_visible[i])
+					continue;
+
+				PxMat44 shapePose(frame_poses[i]);
+				// render object
+				glPushMatrix();						
+				glMultMatrixf((float*)&shapePose);
+
+				if (!depth_only)
+				{
+					const PxVec3& shape_color = snapshot.colors[i];
+					if (type == PxGeometryType::ePLANE)
+						glDisable(GL_LIGHTING);
+					glColor4f(shape_color.x, shape_color.y, shape_color.z, 1.f);
 				}
-#if PX_PHYSICS_VERSION < 0x304000 // SDK 3.3
-				else if (actors[i]->isRigidActor()) {
-#else
-				else if (actors[i]->is<PxRigidActor>()) {
-#endif
-					PxRigidActor* rigid_actor = (PxRigidActor*)actors[i];
-					std::vector<PxShape*> shapes(rigid_actor->getNbShapes());
-					rigid_actor->getShapes((PxShape**)&shapes.front(), (PxU32)shapes.size());
 
-					for(PxU32 j = 0; j < shapes.size(); j++)
-					{
-						const PxShape* shape = shapes[j];
-						PxTransform pose = PxShapeExt::getGlobalPose(*shape, *shape->getActor());
-						PxGeometryHolder h = shape->getGeometry();
-						//move the plane slightly down to avoid visual artefacts
-						if (h.getType() == PxGeometryType::ePLANE)
-						{
-							pose.q *= PxQuat(PxHalfPi, PxVec3(0.f, 0.f, 1.f));
-							pose.p += PxVec3(0,-0.01,0);
-						}
-
-						PxMat44 shapePose(pose);
-						// render object
-						glPushMatrix();						
-						glMultMatrixf((float*)&shapePose);
-
-						PxVec3 shape_color = default_color;
-
-						if (shape->userData)
-						{
-							shape_color = *(((UserData*)shape->userData)->color);
-							if (h.getType() == PxGeometryType::ePLANE)
-							{
-								shadow_color = shape_color*0.9;
-							}
-						}
-
-						if (h.getType() == PxGeometryType::ePLANE)
-							glDisable(GL_LIGHTING);
-
-						glColor4f(shape_color.x, shape_color.y, shape_color.z, 1.f);
-
-						RenderGeometry(h);
-
-						if (h.getType() == PxGeometryType::ePLANE)
-							glEnable(GL_LIGHTING);
-
-						glPopMatrix();
-
-						if(show_shadows && (h.getType() != PxGeometryType::ePLANE))
-						{
-							const PxVec3 shadowDir(-0.7071067f, -0.7071067f, -0.7071067f);
-							const PxReal shadowMat[]={ 1,0,0,0, -shadowDir.x/shadowDir.y,0,-shadowDir.z/shadowDir.y,0, 0,0,1,0, 0,0,0,1 };
-							glPushMatrix();						
-							glMultMatrixf(shadowMat);
-							glMultMatrixf((float*)&shapePose);
-							glDisable(GL_LIGHTING);
-							glColor4f(shadow_color.x, shadow_color.y, shadow_color.z, 1.f);
-							RenderGeometry(h);
-							glEnable(GL_LIGHTING);
-							glPopMatrix();
-						}
-					}
+				RenderGeometry(h);
+
+				if (!depth_only && (type == PxGeometryType::ePLANE))
+					glEnable(GL_LIGHTING);
+
+				glPopMatrix();
+			}
+
+			DrawBatch(batch, depth_only);
+			//shapes outside of the view can still cast shadows into it
+			if (depth_only)
+			{
+				BuildCulledBatch(snapshot);
+				DrawBatch(culled_batch, true);
+			}
+		}
+
+		//render the depth of all shapes as seen from the light
+		void RenderShadowMap(const RenderSnapshot& snapshot)
+		{
+			GLint viewport[4];
+			glGetIntegerv(GL_VIEWPORT, viewport);
+
+			PxVec3 dir = LightDirection();
+			PxVec3 up = (PxAbs(dir.y) > .99f) ? PxVec3(0.f, 0.f, 1.f) : PxVec3(0.f, 1.f, 0.f);
+			PxVec3 eye = shadow_center - dir * shadow_radius * 2.f;
+
+			glMatrixMode(GL_PROJECTION);
+			glPushMatrix();
+			glLoadIdentity();
+			glOrtho(-shadow_radius, shadow_radius, -shadow_radius, shadow_radius, 0.f, shadow_radius * 4.f);
+			glGetFloatv(GL_PROJECTION_MATRIX, light_projection);
+
+			glMatrixMode(GL_MODELVIEW);
+			glPushMatrix();
+			glLoadIdentity();
+			gluLookAt(eye.x, eye.y, eye.z, shadow_center.x, shadow_center.y, shadow_center.z, up.x, up.y, up.z);
+			glGetFloatv(GL_MODELVIEW_MATRIX, light_view);
+
+			GLExtensions::glBindFramebuffer(GL_FRAMEBUFFER, shadow_framebuffer);
+			glViewport(0, 0, shadow_texture_size, shadow_texture_size);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			glDisable(GL_LIGHTING);
+			//push the depth back a little to avoid surfaces shadowing themselves
+			glEnable(GL_POLYGON_OFFSET_FILL);
+			glPolygonOffset(2.f, 4.f);
+
+			DrawShapes(snapshot, true);
+
+			glDisable(GL_POLYGON_OFFSET_FILL);
+			glEnable(GL_LIGHTING);
+			glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+			GLExtensions::glBindFramebuffer(GL_FRAMEBUFFER, 0);
+			glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+			glMatrixMode(GL_PROJECTION);
+			glPopMatrix();
+			glMatrixMode(GL_MODELVIEW);
+			glPopMatrix();
+
+			shadow_poses = snapshot.poses;
+			shadow_map_dirty = false;
+		}
+
+		//did a simulation step move anything since the last depth pass
+		//interpolation alone does not count, the shadows follow the steps and frames in between reuse the depth pass
+		bool ShadowsMoved(const RenderSnapshot& snapshot)
+		{
+			if (shadow_map_dirty || (shadow_poses.size() != snapshot.poses.size()))
+				return true;
+
+			for (PxU32 i = 0; i < snapshot.poses.size(); i++)
+			{
+				const PxTransform& pose = snapshot.poses[i];
+				const PxTransform& shadow_pose = shadow_poses[i];
+				if ((pose.p - shadow_pose.p).magnitudeSquared() > shadow_position_epsilon * shadow_position_epsilon)
+					return true;
+				//q and -q are the same rotation
+				if (PxAbs(pose.q.dot(shadow_pose.q)) < 1.f - shadow_rotation_epsilon)
+					return true;
+			}
+			return false;
+		}
+
+		//shade everything drawn next with the shadow map: lit fragments keep their colour, shadowed ones are darkened by shadow_factor
+		void BeginShadowReceivers()
+		{
+			GLExtensions::glActiveTexture(GL_TEXTURE0);
+
+			//eye linear planes set under the camera view give world positions
+			const GLfloat planes[4][4] = { { 1.f, 0.f, 0.f, 0.f }, { 0.f, 1.f, 0.f, 0.f }, { 0.f, 0.f, 1.f, 0.f }, { 0.f, 0.f, 0.f, 1.f } };
+			const GLenum coords[4] = { GL_S, GL_T, GL_R, GL_Q };
+			const GLenum gens[4] = { GL_TEXTURE_GEN_S, GL_TEXTURE_GEN_T, GL_TEXTURE_GEN_R, GL_TEXTURE_GEN_Q };
+			for (PxU32 i = 0; i < 4; i++)
+			{
+				glTexGeni(coords[i], GL_TEXTURE_GEN_MODE, GL_EYE_LINEAR);
+				glTexGenfv(coords[i], GL_EYE_PLANE, planes[i]);
+				glEnable(gens[i]);
+			}
+
+			//world positions into the [0,1] range of the shadow map
+			glMatrixMode(GL_TEXTURE);
+			glLoadIdentity();
+			glTranslatef(.5f, .5f, .5f);
+			glScalef(.5f, .5f, .5f);
+			glMultMatrixf(light_projection);
+			glMultMatrixf(light_view);
+			glMatrixMode(GL_MODELVIEW);
+
+			glBindTexture(GL_TEXTURE_2D, shadow_texture);
+			glEnable(GL_TEXTURE_2D);
+
+			//first unit: light factor = 1 * comparison + shadow_factor * (1 - comparison), the constant alpha of 0 gives the 1
+			const GLfloat factor[4] = { shadow_factor, shadow_factor, shadow_factor, 0.f };
+			glTexEnvfv(GL_TEXTURE_ENV, GL_TEXTURE_ENV_COLOR, factor);
+			glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+			glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_INTERPOLATE);
+			glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_RGB, GL_CONSTANT);
+			glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE1_RGB, GL_CONSTANT);
+			glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE2_RGB, GL_TEXTURE);
+			glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND0_RGB, GL_ONE_MINUS_SRC_ALPHA);
+			glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND1_RGB, GL_SRC_COLOR);
+			glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND2_RGB, GL_SRC_COLOR);
+			glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_ALPHA, GL_REPLACE);
+			glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_ALPHA, GL_PRIMARY_COLOR);
+
+			//second unit: colour = lit colour * light factor
+			//a unit only combines while it has a texture, the shadow map is bound again but not sampled
+			GLExtensions::glActiveTexture(GL_TEXTURE1);
+			glBindTexture(GL_TEXTURE_2D, shadow_texture);
+			glEnable(GL_TEXTURE_2D);
+			glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+			glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_MODULATE);
+			glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_RGB, GL_PREVIOUS);
+			glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE1_RGB, GL_PRIMARY_COLOR);
+			glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND0_RGB, GL_SRC_COLOR);
+			glTexEnvi(GL_TEXTURE_ENV, GL_OPERAND1_RGB, GL_SRC_COLOR);
+			glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_ALPHA, GL_REPLACE);
+			glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_ALPHA, GL_PRIMARY_COLOR);
+			GLExtensions::glActiveTexture(GL_TEXTURE0);
+		}
+
+		//back to untextured rendering
+		void EndShadowReceivers()
+		{
+			GLExtensions::glActiveTexture(GL_TEXTURE1);
+			glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+			glDisable(GL_TEXTURE_2D);
+			glBindTexture(GL_TEXTURE_2D, 0);
+			GLExtensions::glActiveTexture(GL_TEXTURE0);
+
+			glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_MODULATE);
+			glDisable(GL_TEXTURE_2D);
+			glBindTexture(GL_TEXTURE_2D, 0);
+
+			glMatrixMode(GL_TEXTURE);
+			glLoadIdentity();
+			glMatrixMode(GL_MODELVIEW);
+
+			glDisable(GL_TEXTURE_GEN_S);
+			glDisable(GL_TEXTURE_GEN_T);
+			glDisable(GL_TEXTURE_GEN_R);
+			glDisable(GL_TEXTURE_GEN_Q);
+		}
+
+		//shadows projected onto the ground plane, used when shadow maps are not available
+		void DrawPlanarShadows(const RenderSnapshot& snapshot, const PxVec3& shadow_color)
+		{
+			glPushMatrix();
+			glMultMatrixf(shadow_matrix);
+			glDisable(GL_LIGHTING);
+			glColor4f(shadow_color.x, shadow_color.y, shadow_color.z, 1.f);
+
+			for (PxU32 i = 0; i < snapshot.shapes.size(); i++)
+			{
+				PxGeometryType::Enum type = snapshot.geometries[i].getType();
+				if ((type == PxGeometryType::ePLANE) || Batched(type) || !frame_casts_shadow[i])
+					continue;
+
+				PxMat44 shapePose(frame_poses[i]);
+				glPushMatrix();
+				glMultMatrixf((float*)&shapePose);
+				RenderGeometry(snapshot.geometries[i]);
+				glPopMatrix();
+			}
+
+			DrawBatch(batch, true);
+			BuildCulledBatch(snapshot);
+			DrawBatch(culled_batch, true);
+
+			glEnable(GL_LIGHTING);
+			glPopMatrix();
+		}
+
+		void Render(const RenderSnapshot& snapshot, const RenderSnapshot& previous, PxReal alpha)
+		{
+			PxVec3 shadow_color = default_color*shadow_factor;
+
+			//entries can only be matched if the set of shapes did not change
+			bool interpolate = (alpha < 1.f) && (previous.shapes.size() == snapshot.shapes.size());
+
+			if (lod_render_detail != render_detail)
+				BuildLevelsOfDetail();
+
+			PurgeReleasedMeshes();
+
+			//the depth pass is only repeated when something moved
+			bool shadow_map = show_shadows && UseShadowMap();
+			bool planar_shadows = show_shadows && !shadow_map;
+
+			batch.clear();
+			frame_poses.resize(snapshot.shapes.size());
+			frame_visible.resize(snapshot.shapes.size());
+			frame_casts_shadow.resize(snapshot.shapes.size());
+
+			for (PxU32 i = 0; i < snapshot.shapes.size(); i++)
+			{
+				PxTransform pose = snapshot.poses[i];
+				PxBounds3 bounds = snapshot.bounds[i];
+				if (interpolate && (previous.shapes[i] == snapshot.shapes[i]))
+				{
+					pose = Interpolate(previous.poses[i], pose, alpha);
+					//the interpolated shape lies within both bounds
+					bounds.include(previous.bounds[i]);
 				}
 
+				const PxGeometryHolder& h = snapshot.geometries[i];
+
+				//planes are always visible
+				frame_visible[i] = (h.getType() == PxGeometryType::ePLANE) || Visible(bounds);
+
+				//the shadow map covers hidden shapes as well, planar shadows only need the ones falling into the view
+				frame_casts_shadow[i] = frame_visible[i] || !planar_shadows || Visible(ShadowBounds(bounds));
+
+				//visible boxes, spheres, capsules and convex meshes are drawn together, hidden ones are batched only when their shadows are drawn
+				if (frame_visible[i])
+					AddShape(batch, h, pose, snapshot.colors[i]);
+
+				//move the plane slightly down to avoid visual artefacts
+				if (h.getType() == PxGeometryType::ePLANE)
+				{
+					pose.q *= PxQuat(PxHalfPi, PxVec3(0.f, 0.f, 1.f));
+					pose.p += PxVec3(0,-0.01,0);
+					shadow_color = snapshot.colors[i]*shadow_factor;
+				}
+
+				frame_poses[i] = pose;
+			}
+
+			if (shadow_map)
+			{
+				if (ShadowsMoved(snapshot))
+					RenderShadowMap(snapshot);
+				BeginShadowReceivers();
 			}
+
+			DrawShapes(snapshot, false);
+
+			for (PxU32 i = 0; i < snapshot.cloth_poses.size(); i++)
+				RenderCloth(snapshot, i);
+
+			if (shadow_map)
+				EndShadowReceivers();
+			else if (planar_shadows)
+				DrawPlanarShadows(snapshot, shadow_color);
+
+			PurgeClothCaches();
+			frame_count++;
 		}
 
 		void Finish()
@@ -370,6 +1242,22 @@ namespace VisualDebugger
 			glutSwapBuffers();
 		}
 
+		void Release()
+		{
+			PxGetPhysics().unregisterDeletionListener(deletion_listener);
+
+			for (std::unordered_map<const void*, MeshBuffers>::iterator it = mesh_buffers.begin(); it != mesh_buffers.end(); it++)
+				DeleteMeshBuffers(it->second);
+			mesh_buffers.clear();
+
+			ReleaseShadowMap();
+
+			if (debug_buffer)
+				GLExtensions::glDeleteBuffers(1, &debug_buffer);
+			debug_buffer = 0;
+			debug_buffer_size = 0;
+		}
+
 		void SetRenderDetail(int value)
 		{
 			render_detail = value;
@@ -382,127 +1270,95 @@ namespace VisualDebugger
 
 		bool ShowShadows() { return show_shadows; }
 
-		void RenderBuffer(float* pVertList, float* pColorList, int type, int num)
+		void ShadowMapSize(int value)
 		{
-			glEnableClientState(GL_VERTEX_ARRAY);
-			glVertexPointer(3,GL_FLOAT, 0, pVertList);
-			glEnableClientState(GL_COLOR_ARRAY);
-			glColorPointer(4, GL_FLOAT, 0, pColorList);
-			glDrawArrays(type, 0, num);
-			glDisableClientState(GL_COLOR_ARRAY);
-			glDisableClientState(GL_VERTEX_ARRAY);
+			shadow_map_size = PxMax(value, 1);
+			//a size the driver rejected before may work now
+			shadow_map_failed = false;
+		}
+
+		int ShadowMapSize() { return shadow_map_size; }
+
+		void ShadowArea(const PxVec3& center, PxReal radius)
+		{
+			shadow_center = center;
+			shadow_radius = radius;
+			shadow_map_dirty = true;
 		}
 
 		///Render PxRenderBuffer
 		///TODO: support text data
 		void Render(const PxRenderBuffer& data, PxReal line_width)
 		{
-			glLineWidth(line_width);
+			const GLenum modes[3] = { GL_POINTS, GL_LINES, GL_TRIANGLES };
+			const GLubyte* vertices[3] = { (const GLubyte*)data.getPoints(), (const GLubyte*)data.getLines(), (const GLubyte*)data.getTriangles() };
+			const GLsizei counts[3] = { (GLsizei)data.getNbPoints(), (GLsizei)data.getNbLines()*2, (GLsizei)data.getNbTriangles()*3 };
 
-			//render points
+			size_t total = counts[0] + counts[1] + counts[2];
+			if (!total)
+				return;
 
-			unsigned int NbPoints = data.getNbPoints();
-			if(NbPoints)
+			//the PhysX colours are BGRA bytes in memory, older drivers need a copy in RGBA
+			bool bgra = GLExtensions::HasVertexArrayBGRA();
+			if (!bgra)
 			{
-				std::vector<float> pVertList(NbPoints*3);
-				std::vector<float> pColorList(NbPoints*4);
-				int vertIndex = 0;
-				int colorIndex = 0;
-				const physx::PxDebugPoint* Points = data.getPoints();
-				while(NbPoints--)
+				debug_vertices.resize(total);
+				DebugVertex* out = &debug_vertices.front();
+				for (PxU32 i = 0; i < 3; i++)
 				{
-					pVertList[vertIndex++] = Points->pos.x;
-					pVertList[vertIndex++] = Points->pos.y;
-					pVertList[vertIndex++] = Points->pos.z;
-					pColorList[colorIndex++] = (float)((Points->color>>16)&0xff)/255.f;
-					pColorList[colorIndex++] = (float)((Points->color>>8)&0xff)/255.f;
-					pColorList[colorIndex++] = (float)(Points->color&0xff)/255.f;
-					pColorList[colorIndex++] = 1.f;
-					Points++;
+					const PxDebugPoint* in = (const PxDebugPoint*)vertices[i];
+					vertices[i] = (const GLubyte*)out;
+					for (GLsizei k = 0; k < counts[i]; k++, in++, out++)
+					{
+						out->position = in->pos;
+						out->color[0] = (GLubyte)((in->color>>16)&0xff);
+						out->color[1] = (GLubyte)((in->color>>8)&0xff);
+						out->color[2] = (GLubyte)(in->color&0xff);
+						out->color[3] = 255;
+					}
 				}
-
-				RenderBuffer(&pVertList.front(), &pColorList.front(), GL_POINTS, data.getNbPoints());
 			}
 
-			//render lines
-
-			unsigned int NbLines = data.getNbLines();
-			if(NbLines)
+			//orphan the buffer so the driver does not wait for the previous frame
+			if (GLExtensions::HasVertexBuffers())
 			{
-				std::vector<float> pVertList(NbLines*3*2);
-				std::vector<float> pColorList(NbLines*4*2);
-				int vertIndex = 0;
-				int colorIndex = 0;
-				const PxDebugLine* Lines = data.getLines();
-				while(NbLines--)
+				if (!debug_buffer)
+					GLExtensions::glGenBuffers(1, &debug_buffer);
+				GLExtensions::glBindBuffer(GL_ARRAY_BUFFER, debug_buffer);
+
+				debug_buffer_size = PxMax(debug_buffer_size, total * sizeof(DebugVertex));
+				GLExtensions::glBufferData(GL_ARRAY_BUFFER, debug_buffer_size, 0, GL_STREAM_DRAW);
+
+				size_t offset = 0;
+				for (PxU32 i = 0; i < 3; i++)
 				{
-					pVertList[vertIndex++] = Lines->pos0.x;
-					pVertList[vertIndex++] = Lines->pos0.y;
-					pVertList[vertIndex++] = Lines->pos0.z;
-					pColorList[colorIndex++] = (float)((Lines->color0>>16)&0xff)/255.f;
-					pColorList[colorIndex++] = (float)((Lines->color0>>8)&0xff)/255.f;
-					pColorList[colorIndex++] = (float)(Lines->color0&0xff)/255.f;
-					pColorList[colorIndex++] = 1.f;
-
-					pVertList[vertIndex++] = Lines->pos1.x;
-					pVertList[vertIndex++] = Lines->pos1.y;
-					pVertList[vertIndex++] = Lines->pos1.z;
-					pColorList[colorIndex++] = (float)((Lines->color1>>16)&0xff)/255.f;
-					pColorList[colorIndex++] = (float)((Lines->color1>>8)&0xff)/255.f;
-					pColorList[colorIndex++] = (float)(Lines->color1&0xff)/255.f;
-					pColorList[colorIndex++] = 1.f;
-
-					Lines++;
+					size_t size = counts[i] * sizeof(DebugVertex);
+					if (size)
+						GLExtensions::glBufferSubData(GL_ARRAY_BUFFER, offset, size, vertices[i]);
+					vertices[i] = (const GLubyte*)offset;
+					offset += size;
 				}
-
-				RenderBuffer(&pVertList.front(), &pColorList.front(), GL_LINES, data.getNbLines()*2);
 			}
 
-			//render triangles
+			glLineWidth(line_width);
+			glEnableClientState(GL_VERTEX_ARRAY);
+			glEnableClientState(GL_COLOR_ARRAY);
 
-			unsigned int NbTris = data.getNbTriangles();
-			if(NbTris)
+			for (PxU32 i = 0; i < 3; i++)
 			{
-				std::vector<float> pVertList(NbTris*3*3);
-				std::vector<float> pColorList(NbTris*4*3);
-				int vertIndex = 0;
-				int colorIndex = 0;
-				const PxDebugTriangle* Triangles = data.getTriangles();
-				while(NbTris--)
-				{
-					pVertList[vertIndex++] = Triangles->pos0.x;
-					pVertList[vertIndex++] = Triangles->pos0.y;
-					pVertList[vertIndex++] = Triangles->pos0.z;
-
-					pVertList[vertIndex++] = Triangles->pos1.x;
-					pVertList[vertIndex++] = Triangles->pos1.y;
-					pVertList[vertIndex++] = Triangles->pos1.z;
-
-					pVertList[vertIndex++] = Triangles->pos2.x;
-					pVertList[vertIndex++] = Triangles->pos2.y;
-					pVertList[vertIndex++] = Triangles->pos2.z;
-
-					pColorList[colorIndex++] = (float)((Triangles->color0>>16)&0xff)/255.f;
-					pColorList[colorIndex++] = (float)((Triangles->color0>>8)&0xff)/255.f;
-					pColorList[colorIndex++] = (float)(Triangles->color0&0xff)/255.f;
-					pColorList[colorIndex++] = 1.f;
-
-					pColorList[colorIndex++] = (float)((Triangles->color1>>16)&0xff)/255.f;
-					pColorList[colorIndex++] = (float)((Triangles->color1>>8)&0xff)/255.f;
-					pColorList[colorIndex++] = (float)(Triangles->color1&0xff)/255.f;
-					pColorList[colorIndex++] = 1.f;
-
-					pColorList[colorIndex++] = (float)((Triangles->color2>>16)&0xff)/255.f;
-					pColorList[colorIndex++] = (float)((Triangles->color2>>8)&0xff)/255.f;
-					pColorList[colorIndex++] = (float)(Triangles->color2&0xff)/255.f;
-					pColorList[colorIndex++] = 1.f;
-
-					Triangles++;
-				}
-
-				RenderBuffer(&pVertList.front(), &pColorList.front(), GL_TRIANGLES, data.getNbTriangles()*3);
+				if (!counts[i])
+					continue;
+				glVertexPointer(3, GL_FLOAT, sizeof(DebugVertex), vertices[i] + offsetof(DebugVertex, position));
+				glColorPointer(bgra ? GL_BGRA : 4, GL_UNSIGNED_BYTE, sizeof(DebugVertex), vertices[i] + offsetof(DebugVertex, color));
+				glDrawArrays(modes[i], 0, counts[i]);
 			}
 
+			glDisableClientState(GL_COLOR_ARRAY);
+			glDisableClientState(GL_VERTEX_ARRAY);
+
+			if (debug_buffer)
+				GLExtensions::glBindBuffer(GL_ARRAY_BUFFER, 0);
+
 			//TODO: render texts ?
 		}
 
@@ -2,6 +2,7 @@
 
 #include "PxPhysicsAPI.h"
 #include "GLFontRenderer.h"
+#include "RenderSnapshot.h"
 #include <GL/glut.h>
 #include <string>
 
@@ -20,8 +21,11 @@ namespace VisualDebugger
 		///Start rendering a single frame
 		void Start(const PxVec3& cameraEye, const PxVec3& cameraDir);
 
-		///Render actors
-		void Render(PxActor** actors, const PxU32 numActors);
+		///Get the world bounds of the view set up by Start, cut at the given distance from the camera
+		PxBounds3 ViewBounds(PxReal distance);
+
+		///Render a scene snapshot, poses are interpolated from the previous snapshot by alpha
+		void Render(const RenderSnapshot& snapshot, const RenderSnapshot& previous, PxReal alpha=1.f);
 
 		///Render debug information
 		void Render(const PxRenderBuffer& data, PxReal line_width=1.f);
@@ -36,7 +40,10 @@ namespace VisualDebugger
 		///Finish rendering a single frame
 		void Finish();
 
-		///Set rendering detail for spheres and capsules.
+		///Release renderer resources, before PhysX is released
+		void Release();
+
+		///Set rendering detail for spheres and capsules close to the camera, distant ones use coarser levels.
 		void SetRenderDetail(int value);
 
 		///Set show shadows
@@ -44,5 +51,14 @@ namespace VisualDebugger
 
 		///Get show shadows
 		bool ShowShadows();
+
+		///Set the resolution of the shadow map (texels per side)
+		void ShadowMapSize(int value);
+
+		///Get the resolution of the shadow map
+		int ShadowMapSize();
+
+		///Set the region covered by the shadow map: a sphere around the center
+		void ShadowArea(const PxVec3& center, PxReal radius);
 	}
 }
\ No newline at end of file
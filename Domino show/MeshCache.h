@@ -0,0 +1,354 @@
+#pragma once
+
+#include "PhysicsEngine.h"
+#include <iomanip>
+#include <sstream>
+#include <cstdio>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace PhysicsEngine
+{
+	///Cooked meshes shared by all actors with identical geometry.
+	///Meshes are looked up by hashes of their vertices, indices, flags and the cooking parameters, so repeated geometry is cooked once per process.
+	///Once a cache directory is set, cooked data is also kept there, so later runs load it instead of cooking again.
+	///The cache keeps the reference returned on creation, every shape using a mesh holds its own PhysX reference.
+	class MeshCache
+	{
+	public:
+		///Set the directory of cooked mesh files (empty = no files, the default)
+		static void Directory(const std::string& path)
+		{
+			DirectoryPath() = path;
+		}
+
+		///Get the directory of cooked mesh files
+		static const std::string& Directory()
+		{
+			return DirectoryPath();
+		}
+
+		///Get the cooked convex mesh, cook it on the first request
+		static PxConvexMesh* Convex(const PxConvexMeshDesc& mesh_desc)
+		{
+			Key key = MakeKey(mesh_desc);
+			PxConvexMesh* mesh = Find(ConvexMeshes(), key);
+			if (mesh)
+				return mesh;
+
+			std::string path = FilePath(key, "convex");
+
+			//cooked by an earlier run
+			std::vector<unsigned char> data;
+			if (Load(path, key, data))
+			{
+				PxDefaultMemoryInputData input(&data.front(), (PxU32)data.size());
+				mesh = GetPhysics()->createConvexMesh(input);
+			}
+
+			if (!mesh)
+			{
+				PxDefaultMemoryOutputStream stream;
+
+				if(!GetCooking()->cookConvexMesh(mesh_desc, stream))
+					throw new Exception("ConvexMesh::CookMesh, cooking failed.");
+
+				PxDefaultMemoryInputData input(stream.getData(), stream.getSize());
+
+				mesh = GetPhysics()->createConvexMesh(input);
+				if (!mesh)
+					throw new Exception("ConvexMesh::CookMesh, could not create the mesh.");
+
+				Store(path, key, stream);
+			}
+
+			ConvexMeshes().insert(std::make_pair(key.hash, Entry<PxConvexMesh>(key, mesh)));
+			return mesh;
+		}
+
+		///Get the cooked triangle mesh, cook it on the first request
+		static PxTriangleMesh* Triangle(const PxTriangleMeshDesc& mesh_desc)
+		{
+			Key key = MakeKey(mesh_desc);
+			PxTriangleMesh* mesh = Find(TriangleMeshes(), key);
+			if (mesh)
+				return mesh;
+
+			std::string path = FilePath(key, "triangle");
+
+			//cooked by an earlier run
+			std::vector<unsigned char> data;
+			if (Load(path, key, data))
+			{
+				PxDefaultMemoryInputData input(&data.front(), (PxU32)data.size());
+				mesh = GetPhysics()->createTriangleMesh(input);
+			}
+
+			if (!mesh)
+			{
+				PxDefaultMemoryOutputStream stream;
+
+				if(!GetCooking()->cookTriangleMesh(mesh_desc, stream))
+					throw new Exception("TriangleMesh::CookMesh, cooking failed.");
+
+				PxDefaultMemoryInputData input(stream.getData(), stream.getSize());
+
+				mesh = GetPhysics()->createTriangleMesh(input);
+				if (!mesh)
+					throw new Exception("TriangleMesh::CookMesh, could not create the mesh.");
+
+				Store(path, key, stream);
+			}
+
+			TriangleMeshes().insert(std::make_pair(key.hash, Entry<PxTriangleMesh>(key, mesh)));
+			return mesh;
+		}
+
+		///Drop the references held by the cache, meshes still used by shapes stay alive
+		static void Clear()
+		{
+			for (ConvexMap::iterator it = ConvexMeshes().begin(); it != ConvexMeshes().end(); it++)
+				it->second.mesh->release();
+			for (TriangleMap::iterator it = TriangleMeshes().begin(); it != TriangleMeshes().end(); it++)
+				it->second.mesh->release();
+			ConvexMeshes().clear();
+			TriangleMeshes().clear();
+		}
+
+	private:
+		//two independent 64-bit hashes of everything the cooked data depends on and the sizes of the source data
+		//the first hash picks the bucket, the second one and the sizes tell hash collisions apart without keeping the source
+		struct Key
+		{
+			PxU64 hash;
+			PxU64 check;
+			PxU64 size;
+			PxU32 points;
+			PxU32 elements;
+
+			Key() : hash(FNV_OFFSET), check(CHECK_OFFSET), size(0), points(0), elements(0) {}
+
+			bool operator==(const Key& key) const
+			{
+				return (hash == key.hash) && (check == key.check) && (size == key.size) && (points == key.points) && (elements == key.elements);
+			}
+		};
+
+		//a cooked mesh and the key of the source data it was cooked from
+		template<class MeshType>
+		struct Entry
+		{
+			Key key;
+			MeshType* mesh;
+
+			Entry(const Key& _key, MeshType* _mesh) : key(_key), mesh(_mesh) {}
+		};
+
+		typedef std::unordered_multimap<PxU64, Entry<PxConvexMesh> > ConvexMap;
+		typedef std::unordered_multimap<PxU64, Entry<PxTriangleMesh> > TriangleMap;
+
+		//FNV-1a
+		static const PxU64 FNV_OFFSET = 14695981039346656037ULL;
+		static const PxU64 FNV_PRIME = 1099511628211ULL;
+		//rotate, xor and multiply by the golden ratio, unrelated to FNV
+		static const PxU64 CHECK_OFFSET = 0x243F6A8885A308D3ULL;
+		static const PxU64 CHECK_PRIME = 0x9E3779B97F4A7C15ULL;
+
+		static Key MakeKey(const PxConvexMeshDesc& mesh_desc)
+		{
+			Key key;
+			key.points = mesh_desc.points.data ? mesh_desc.points.count : 0;
+			key.elements = mesh_desc.polygons.data ? mesh_desc.polygons.count : 0;
+			Append(key, "convex", 6);
+			Append(key, mesh_desc.points, sizeof(PxVec3));
+			Append(key, mesh_desc.polygons, sizeof(PxHullPolygon));
+			Append(key, mesh_desc.indices, (mesh_desc.flags & PxConvexFlag::e16_BIT_INDICES) ? sizeof(PxU16) : sizeof(PxU32));
+			AppendValue(key, (PxU32)mesh_desc.flags);
+			AppendValue(key, mesh_desc.vertexLimit);
+			AppendParams(key);
+			return key;
+		}
+
+		static Key MakeKey(const PxTriangleMeshDesc& mesh_desc)
+		{
+			Key key;
+			key.points = mesh_desc.points.data ? mesh_desc.points.count : 0;
+			key.elements = mesh_desc.triangles.data ? mesh_desc.triangles.count : 0;
+			Append(key, "triangle", 8);
+			Append(key, mesh_desc.points, sizeof(PxVec3));
+			Append(key, mesh_desc.triangles, ((mesh_desc.flags & PxMeshFlag::e16_BIT_INDICES) ? sizeof(PxU16) : sizeof(PxU32)) * 3);
+			AppendValue(key, (PxU32)mesh_desc.flags);
+			AppendParams(key);
+			return key;
+		}
+
+		//the cooking parameters that change the cooked data
+		static void AppendParams(Key& key)
+		{
+			const PxCookingParams& params = GetCooking()->getParams();
+			AppendValue(key, params.scale.length);
+			AppendValue(key, params.scale.mass);
+			AppendValue(key, params.scale.speed);
+			AppendValue(key, params.areaTestEpsilon);
+			AppendValue(key, (PxU32)params.meshPreprocessParams);
+			AppendValue(key, params.meshWeldTolerance);
+			AppendValue(key, params.suppressTriangleMeshRemapTable);
+			AppendValue(key, params.buildTriangleAdjacencies);
+#if PX_PHYSICS_VERSION < 0x304000 // SDK 3.3
+			AppendValue(key, (PxU32)params.meshCookingHint);
+			AppendValue(key, params.meshSizePerformanceTradeOff);
+#else
+			AppendValue(key, params.planeTolerance);
+			AppendValue(key, (PxU32)params.convexMeshCookingType);
+			AppendValue(key, params.buildGPUData);
+			AppendValue(key, params.gaussMapLimit);
+			AppendValue(key, (PxU32)params.midphaseDesc.getType());
+#endif
+		}
+
+		//feed bytes to both hashes, nothing is copied
+		static void Append(Key& key, const void* bytes, size_t size)
+		{
+			const unsigned char* data = (const unsigned char*)bytes;
+			for (size_t i = 0; i < size; i++)
+			{
+				key.hash ^= data[i];
+				key.hash *= FNV_PRIME;
+				key.check = ((key.check << 5) | (key.check >> 59)) ^ data[i];
+				key.check *= CHECK_PRIME;
+			}
+			key.size += size;
+		}
+
+		template<class ValueType>
+		static void AppendValue(Key& key, const ValueType& value)
+		{
+			Append(key, &value, sizeof(value));
+		}
+
+		//the elements of strided data, tightly packed and preceded by their count
+		static void Append(Key& key, const PxBoundedData& bounded, size_t element_size)
+		{
+			PxU32 count = bounded.data ? bounded.count : 0;
+			AppendValue(key, count);
+
+			PxU32 stride = bounded.stride ? bounded.stride : (PxU32)element_size;
+			for (PxU32 i = 0; i < count; i++)
+				Append(key, (const unsigned char*)bounded.data + i * stride, element_size);
+		}
+
+		//a cached mesh cooked from the same source data
+		template<class MeshType>
+		static MeshType* Find(std::unordered_multimap<PxU64, Entry<MeshType> >& meshes, const Key& key)
+		{
+			typedef typename std::unordered_multimap<PxU64, Entry<MeshType> >::iterator Iterator;
+			std::pair<Iterator, Iterator> range = meshes.equal_range(key.hash);
+			for (Iterator it = range.first; it != range.second; it++)
+			{
+				if (it->second.key == key)
+					return it->second.mesh;
+			}
+			return 0;
+		}
+
+		//file of a cooked mesh, the name includes the PhysX version and pointer size as cooked data depends on both
+		static std::string FilePath(const Key& key, const char* type)
+		{
+			if (DirectoryPath().empty())
+				return std::string();
+
+			std::ostringstream path;
+			path << DirectoryPath() << "/" << std::hex << std::setfill('0') << std::setw(16) << key.hash
+				<< "_" << std::setw(8) << PX_PHYSICS_VERSION << std::dec << "_" << sizeof(void*) * 8 << "." << type;
+			return path.str();
+		}
+
+		//read the cooked data of a file, the file starts with the key of the source data it was cooked from
+		static bool Load(const std::string& path, const Key& key, std::vector<unsigned char>& cooked)
+		{
+			if (path.empty())
+				return false;
+
+			PxDefaultFileInputData file(path.c_str());
+			if (!file.isValid())
+				return false;
+
+			PxU32 length = file.getLength();
+			if (length <= sizeof(Key))
+				return false;
+
+			Key header;
+			if ((file.read(&header, sizeof(Key)) != sizeof(Key)) || !(header == key))
+				return false;
+
+			cooked.resize(length - sizeof(Key));
+			return (file.read(&cooked.front(), (PxU32)cooked.size()) == cooked.size());
+		}
+
+		//write the cooked data to a temporary file first, so other runs never load a partially written file
+		static void Store(const std::string& path, const Key& key, PxDefaultMemoryOutputStream& stream)
+		{
+			if (path.empty())
+				return;
+
+#ifdef _WIN32
+			_mkdir(DirectoryPath().c_str());
+#else
+			mkdir(DirectoryPath().c_str(), 0755);
+#endif
+
+			//the temporary name is unique per process and write, so concurrent runs never share a file
+			static PxU32 writes = 0;
+			std::ostringstream temp_path_stream;
+#ifdef _WIN32
+			temp_path_stream << path << "." << _getpid() << "." << writes++ << ".tmp";
+#else
+			temp_path_stream << path << "." << getpid() << "." << writes++ << ".tmp";
+#endif
+			std::string temp_path = temp_path_stream.str();
+			bool written = false;
+			{
+				PxDefaultFileOutputStream file(temp_path.c_str());
+				if (file.isValid())
+					written = (file.write(&key, sizeof(Key)) == sizeof(Key)) &&
+						(file.write(stream.getData(), stream.getSize()) == stream.getSize());
+			}
+
+			//replace the file in a single step, other runs see either the old or the new file
+#ifdef _WIN32
+			bool replaced = written && MoveFileExA(temp_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING);
+#else
+			bool replaced = written && !std::rename(temp_path.c_str(), path.c_str());
+#endif
+			if (!replaced)
+				std::remove(temp_path.c_str());
+		}
+
+		static std::string& DirectoryPath()
+		{
+			static std::string path;
+			return path;
+		}
+
+		static ConvexMap& ConvexMeshes()
+		{
+			static ConvexMap meshes;
+			return meshes;
+		}
+
+		static TriangleMap& TriangleMeshes()
+		{
+			static TriangleMap meshes;
+			return meshes;
+		}
+	};
+}
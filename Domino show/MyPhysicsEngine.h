@@ -69,20 +69,31 @@ namespace PhysicsEngine
 	public:
 		MySimulationEventCallback* my_callback;
 		int num_domino = 93;
+		//all dominos created by createDominos, in order of creation
+		std::vector<Domino*> dominos;
 
 		///A custom scene class
+		MyScene()
+		{
+			SetVisualisation();
+		}
+
+		//Default debug geometry, the categories can be toggled at run time and survive resets
 		void SetVisualisation()
 		{
-			px_scene->setVisualizationParameter(PxVisualizationParameter::eSCALE, 1.0f);
-			px_scene->setVisualizationParameter(PxVisualizationParameter::eCOLLISION_SHAPES, 1.0f);
-			px_scene->setVisualizationParameter(PxVisualizationParameter::eJOINT_LOCAL_FRAMES, 1.0f);
-			px_scene->setVisualizationParameter(PxVisualizationParameter::eJOINT_LIMITS, 1.0f);
+			Visualization(PxVisualizationParameter::eSCALE, 1.0f);
+			Visualization(PxVisualizationParameter::eCOLLISION_SHAPES, 1.0f);
+			Visualization(PxVisualizationParameter::eJOINT_LOCAL_FRAMES, 1.0f);
+			Visualization(PxVisualizationParameter::eJOINT_LIMITS, 1.0f);
 		}
 
 		//Custom scene initialisation
 		virtual void CustomInit()
 		{
-			SetVisualisation();
+			dominos.clear();
+
+			// cook the pebble now rather than when the show begins
+			ConvexMesh::CookMesh(pebbleVertices());
 
 			GetMaterial()->setDynamicFriction(.2f);
 
@@ -195,6 +206,7 @@ namespace PhysicsEngine
 				//Domino* domino = new Domino(PxTransform(PxVec3(x, y, z)));
 				domino->Color(PxVec3(.0f, 0.f, 1.f)); // colour the domino red
 				Add(domino);
+				dominos.push_back(domino);
 			}
 			return PxVec3(pos[0], pos[1], pos[2]);
 		}
@@ -322,7 +334,13 @@ namespace PhysicsEngine
 
 		void beginShow() {
 			// This begins the show by creating a "pebble" (convex mesh) atop a plank.
+			ConvexMesh* pebble = new ConvexMesh(pebbleVertices(), PxTransform(PxVec3(-3.5f, 4.f, 0.f), PxQuat(1.5807f, PxVec3(0.f, 1.f, 0.f))), 1.f);
+			pebble->Color(PxVec3(.75f, .75f, .75f));
+			Add(pebble);
+		}
 
+		// vertices of the pebble dropped by beginShow
+		static std::vector<PxVec3> pebbleVertices() {
 			float scale = .05f;
 			std::vector<PxVec3> pebble_desc{
 				PxVec3(.0f, .9f, .0f) * scale, // top most point
@@ -344,9 +362,7 @@ namespace PhysicsEngine
 				PxVec3(-.7f, -.5f, -.7f)* scale,
 				PxVec3(.0f, -.9f, .0f)* scale, // bottom most point
 			};
-			ConvexMesh* pebble = new ConvexMesh(pebble_desc, PxTransform(PxVec3(-3.5f, 4.f, 0.f), PxQuat(1.5807f, PxVec3(0.f, 1.f, 0.f))), 1.f);
-			pebble->Color(PxVec3(.75f, .75f, .75f));
-			Add(pebble);
+			return pebble_desc;
 		}
 
 		void ruinShow() {
@@ -1,4 +1,5 @@
 #include "PhysicsEngine.h"
+#include "MeshCache.h"
 #include <iostream>
 
 namespace PhysicsEngine
@@ -20,6 +21,37 @@ namespace PhysicsEngine
 	PxPhysics* physics = 0;
 	PxCooking* cooking = 0;
 
+	//all materials created through CreateMaterial and SharedMaterial, in order of creation
+	std::vector<PxMaterial*> materials;
+
+	//properties of a shared material
+	struct MaterialKey
+	{
+		PxReal sf, df, cr;
+		PxCombineMode::Enum friction_mode, restitution_mode;
+
+		bool operator==(const MaterialKey& other) const
+		{
+			return (sf == other.sf) && (df == other.df) && (cr == other.cr) &&
+				(friction_mode == other.friction_mode) && (restitution_mode == other.restitution_mode);
+		}
+	};
+
+	struct MaterialKeyHash
+	{
+		size_t operator()(const MaterialKey& key) const
+		{
+			std::hash<PxReal> hash;
+			size_t h = hash(key.sf);
+			h = h * 31 + hash(key.df);
+			h = h * 31 + hash(key.cr);
+			return h * 31 + (key.friction_mode << 4 | key.restitution_mode);
+		}
+	};
+
+	//shared materials
+	std::unordered_map<MaterialKey, PxMaterial*, MaterialKeyHash> shared_materials;
+
 	///PhysX functions
 	void PxInit()
 	{
@@ -70,6 +102,11 @@ namespace PhysicsEngine
 
 	void PxRelease()
 	{
+		//materials are released together with the physics object
+		materials.clear();
+		shared_materials.clear();
+		MeshCache::Clear();
+
 		if (cooking)
 			cooking->release();
 		if (physics)
@@ -92,8 +129,7 @@ namespace PhysicsEngine
 
 	PxMaterial* GetMaterial(PxU32 index)
 	{
-		std::vector<PxMaterial*> materials(physics->getNbMaterials());
-		if (index < physics->getMaterials((PxMaterial**)&materials.front(), (PxU32)materials.size()))
+		if (index < materials.size())
 			return materials[index];
 		else
 			return 0;
@@ -101,7 +137,28 @@ namespace PhysicsEngine
 
 	PxMaterial* CreateMaterial(PxReal sf, PxReal df, PxReal cr) 
 	{
-		return physics->createMaterial(sf, df, cr);
+		PxMaterial* material = physics->createMaterial(sf, df, cr);
+		if (material)
+			materials.push_back(material);
+		return material;
+	}
+
+	PxMaterial* SharedMaterial(PxReal sf, PxReal df, PxReal cr, PxCombineMode::Enum friction_mode, PxCombineMode::Enum restitution_mode)
+	{
+		MaterialKey key = { sf, df, cr, friction_mode, restitution_mode };
+
+		std::unordered_map<MaterialKey, PxMaterial*, MaterialKeyHash>::iterator it = shared_materials.find(key);
+		if (it != shared_materials.end())
+			return it->second;
+
+		PxMaterial* material = CreateMaterial(sf, df, cr);
+		if (!material)
+			throw new Exception("PhysicsEngine::SharedMaterial, Could not create the material.");
+
+		material->setFrictionCombineMode(friction_mode);
+		material->setRestitutionCombineMode(restitution_mode);
+		shared_materials[key] = material;
+		return material;
 	}
 
 	///Actor methods
@@ -148,8 +205,7 @@ namespace PhysicsEngine
 
 	PxShape* Actor::GetShape(PxU32 index)
 	{
-		std::vector<PxShape*> shapes(((PxRigidActor*)actor)->getNbShapes());
-		if (index < ((PxRigidActor*)actor)->getShapes((PxShape**)&shapes.front(), (PxU32)shapes.size()))
+		if (index < shapes.size())
 			return shapes[index];
 		else
 			return 0;
@@ -157,8 +213,6 @@ namespace PhysicsEngine
 
 	std::vector<PxShape*> Actor::GetShapes(PxU32 index)
 	{
-		std::vector<PxShape*> shapes(((PxRigidActor*)actor)->getNbShapes());
-		((PxRigidActor*)actor)->getShapes((PxShape**)&shapes.front(), (PxU32)shapes.size());
 		if (index == -1)
 			return shapes;
 		else if (index < shapes.size())
@@ -169,6 +223,34 @@ namespace PhysicsEngine
 			return std::vector<PxShape*>();
 	}
 
+	void Actor::AddShape(PxShape* shape)
+	{
+		shapes.push_back(shape);
+		colors.push_back(default_color);
+		//pass the color pointer to the renderer
+		shape->userData = new UserData(&colors.back());
+	}
+
+	void Actor::CreateShapes(const std::vector<PxGeometryHolder>& geometries, const std::vector<PxTransform>& local_poses, PxReal density, PxMaterial* material)
+	{
+		if (geometries.size() != local_poses.size())
+			throw new Exception("PhysicsEngine::Actor::CreateShapes, Number of geometries and local poses differs.");
+
+		if (!material)
+			material = GetMaterial();
+
+		for (PxU32 i = 0; i < geometries.size(); i++)
+		{
+			PxShape* shape = ((PxRigidActor*)actor)->createShape(geometries[i].any(), *material);
+			shape->setLocalPose(local_poses[i]);
+			AddShape(shape);
+		}
+
+		//mass properties of all shapes at their final poses
+		if (actor->getType() == PxActorType::eRIGID_DYNAMIC)
+			PxRigidBodyExt::updateMassAndInertia(*(PxRigidDynamic*)actor, density);
+	}
+
 	void Actor::Name(const string& new_name)
 	{
 		name = new_name;
@@ -188,30 +270,22 @@ namespace PhysicsEngine
 
 	DynamicActor::~DynamicActor()
 	{
-		for (unsigned int i = 0; i < colors.size(); i++)
-			delete (UserData*)GetShape(i)->userData;
+		for (unsigned int i = 0; i < shapes.size(); i++)
+			delete (UserData*)shapes[i]->userData;
 	}
 
 	void DynamicActor::CreateShape(const PxGeometry& geometry, PxReal density)
 	{
 		PxShape* shape = ((PxRigidDynamic*)actor)->createShape(geometry,*GetMaterial());
 		PxRigidBodyExt::updateMassAndInertia(*(PxRigidDynamic*)actor, density);
-		colors.push_back(default_color);
-		//pass the color pointers to the renderer
-		shape->userData = new UserData();
-		for (unsigned int i = 0; i < colors.size(); i++)
-			((UserData*)GetShape(i)->userData)->color = &colors[i];
+		AddShape(shape);
 	}
 
 	void DynamicActor::CreateShape(const PxGeometry& geometry, PxReal density, PxMaterial* material)
 	{
 		PxShape* shape = ((PxRigidDynamic*)actor)->createShape(geometry, *material);
 		PxRigidBodyExt::updateMassAndInertia(*(PxRigidDynamic*)actor, density);
-		colors.push_back(default_color);
-		//pass the color pointers to the renderer
-		shape->userData = new UserData();
-		for (unsigned int i = 0; i < colors.size(); i++)
-			((UserData*)GetShape(i)->userData)->color = &colors[i];
+		AddShape(shape);
 	}
 
 	void DynamicActor::SetKinematic(bool value, PxU32 index)
@@ -241,34 +315,82 @@ namespace PhysicsEngine
 
 	StaticActor::~StaticActor()
 	{
-		for (unsigned int i = 0; i < colors.size(); i++)
-			delete (UserData*)GetShape(i)->userData;
+		for (unsigned int i = 0; i < shapes.size(); i++)
+			delete (UserData*)shapes[i]->userData;
 	}
 
 	void StaticActor::CreateShape(const PxGeometry& geometry, PxReal density)
 	{
 		PxShape* shape = ((PxRigidStatic*)actor)->createShape(geometry,*GetMaterial());
-		colors.push_back(default_color);
-		//pass the color pointers to the renderer
-		shape->userData = new UserData();
-		for (unsigned int i = 0; i < colors.size(); i++)
-			((UserData*)GetShape(i)->userData)->color = &colors[i];
+		AddShape(shape);
 	}
 
 	///Scene methods
+	Scene::Scene()
+		: px_scene(0), cpu_dispatcher(0), dispatcher_type(DEFAULT_DISPATCHER), pause(false), stepping(false), publish_step(true), accumulator(0.f), alpha(0.f), front_snapshot(0), pose_table_dirty(true), pose_table_layout(0), active_count(0),
+		show_visualization(false), visualization_box(PxBounds3::empty()), selected_actor(0), selected_force(0.f)
+	{
+		for (PxU32 i = 0; i < PxVisualizationParameter::eNUM_VALUES; i++)
+			visualization[i] = 0.f;
+
+		//no snapshot holds a pose table yet
+		for (PxU32 i = 0; i < SNAPSHOT_COUNT; i++)
+			snapshot_layouts[i] = PxU32(-1);
+	}
+
+	Scene::~Scene()
+	{
+		Release();
+	}
+
+	void Scene::Config(const SceneConfig& value)
+	{
+		config = value;
+	}
+
+	const SceneConfig& Scene::Config()
+	{
+		return config;
+	}
+
 	void Scene::Init()
 	{
 		//scene
 		PxSceneDesc sceneDesc(GetPhysics()->getTolerancesScale());
 
-		if(!sceneDesc.cpuDispatcher)
+		if (!cpu_dispatcher)
 		{
-			PxDefaultCpuDispatcher* mCpuDispatcher = PxDefaultCpuDispatcherCreate(1);
-			sceneDesc.cpuDispatcher = mCpuDispatcher;
+			PxU32* affinity_masks = 0;
+			if (config.affinity_masks.size())
+			{
+				if (config.affinity_masks.size() != config.num_threads)
+					throw new Exception("PhysicsEngine::Scene::Init, the number of affinity masks does not match the number of threads.");
+				affinity_masks = &config.affinity_masks.front();
+			}
+
+			if (config.dispatcher == WORK_STEALING_DISPATCHER)
+				cpu_dispatcher = WorkStealingDispatcher::Create(config.num_threads, affinity_masks);
+			else
+				cpu_dispatcher = PxDefaultCpuDispatcherCreate(config.num_threads, affinity_masks);
+
+			dispatcher_type = config.dispatcher;
+
+			if (!cpu_dispatcher)
+				throw new Exception("PhysicsEngine::Scene::Init, Could not create the CPU dispatcher.");
 		}
 
+		sceneDesc.cpuDispatcher = cpu_dispatcher;
+
 		sceneDesc.filterShader = PxDefaultSimulationFilterShader;
 
+		//report the actors moved by each step so render poses can be updated incrementally
+		if (config.publish_snapshots)
+#if PX_PHYSICS_VERSION < 0x304000 // SDK 3.3
+			sceneDesc.flags |= PxSceneFlag::eENABLE_ACTIVETRANSFORMS;
+#else
+			sceneDesc.flags |= PxSceneFlag::eENABLE_ACTIVE_ACTORS;
+#endif
+
 		px_scene = GetPhysics()->createScene(sceneDesc);
 
 		if (!px_scene)
@@ -277,34 +399,325 @@ namespace PhysicsEngine
 		//default gravity
 		px_scene->setGravity(PxVec3(0.0f, -9.81f, 0.0f));
 
+		ApplyVisualization();
+
 		CustomInit();
 
 		pause = false;
 
+		accumulator = 0.f;
+		alpha = 0.f;
+
+		//the latest and the previous snapshot start with the initial state
+		pose_table_dirty = true;
+		active_count = 0;
+		if (config.publish_snapshots)
+		{
+			PublishSnapshot();
+			PublishSnapshot();
+		}
+
 		selected_actor = 0;
+		selected_force = PxVec3(0.f);
 
 		SelectNextActor();
 	}
 
 	void Scene::Update(PxReal dt)
+	{
+		BeginStep(dt);
+		CompleteStep();
+	}
+
+	void Scene::BeginStep(PxReal dt)
 	{
 		if (pause)
 			return;
 
-		CustomUpdate();
+		//only a single step can be in flight
+		CompleteStep();
+
+		{
+			PROFILE_SCOPE(PHASE_CUSTOM_UPDATE);
+			CustomUpdate();
+		}
+
+		//forces last for a single step, applying them per step keeps the push independent of the frame rate
+		if (selected_actor && !selected_force.isZero())
+			selected_actor->addForce(selected_force);
+
+		PROFILE_START(step_timer);
+		{
+			PROFILE_SCOPE(PHASE_SIMULATE);
+			px_scene->simulate(dt);
+		}
+		stepping = true;
+		publish_step = true;
+	}
+
+	bool Scene::StepDone()
+	{
+		if (!stepping)
+			return true;
+
+		return px_scene->checkResults(false);
+	}
+
+	void Scene::CompleteStep()
+	{
+		if (!stepping)
+			return;
+
+		{
+			PROFILE_SCOPE(PHASE_FETCH_RESULTS);
+			px_scene->fetchResults(true);
+		}
+		PROFILE_STOP(step_timer, PHASE_STEP);
+		stepping = false;
+
+		px_scene->getSimulationStatistics(statistics);
+
+		//the pose table follows every step, only the snapshots that can be rendered are published
+		if (config.publish_snapshots)
+		{
+			PROFILE_SCOPE(PHASE_PUBLISH);
+			UpdatePoseTable();
+			if (publish_step)
+				CopySnapshot();
+		}
+	}
+
+	bool Scene::Stepping()
+	{
+		return stepping;
+	}
+
+	void Scene::Advance(PxReal frame_time)
+	{
+		if (pause)
+			return;
+
+		accumulator += frame_time;
+
+		PxU32 steps = (PxU32)(accumulator / config.fixed_dt);
+		//the simulation cannot keep up, drop the time it did not manage to simulate
+		if (steps > config.max_substeps)
+		{
+			steps = config.max_substeps;
+			accumulator = steps * config.fixed_dt;
+		}
+
+		accumulator -= steps * config.fixed_dt;
+
+		for (PxU32 i = 0; i < steps; i++)
+		{
+			BeginStep(config.fixed_dt);
+			//only the last two steps of a frame are interpolated between
+			publish_step = (i + 2 >= steps);
+			if (i + 1 < steps)
+				CompleteStep();
+		}
+
+		alpha = accumulator / config.fixed_dt;
+	}
+
+	PxReal Scene::Alpha()
+	{
+		return alpha;
+	}
+
+	void Scene::BuildPoseTable()
+	{
+		pose_table.Clear();
+		local_poses.clear();
+		color_sources.clear();
+		actor_rows.clear();
+		cloths.clear();
+
+		std::vector<PxActor*> actors = GetAllActors();
+		for (PxU32 i = 0; i < actors.size(); i++)
+		{
+#if PX_PHYSICS_VERSION < 0x304000 // SDK 3.3
+			if (actors[i]->isCloth())
+#else
+			if (actors[i]->is<PxCloth>())
+#endif
+			{
+				cloths.push_back((PxCloth*)actors[i]);
+			}
+			else
+			{
+				PxRigidActor* rigid_actor = (PxRigidActor*)actors[i];
+				shape_buffer.resize(rigid_actor->getNbShapes());
+				if (!shape_buffer.size())
+					continue;
+				rigid_actor->getShapes(&shape_buffer.front(), (PxU32)shape_buffer.size());
+
+				actor_rows[rigid_actor] = std::make_pair((PxU32)pose_table.shapes.size(), (PxU32)shape_buffer.size());
+
+				for (PxU32 j = 0; j < shape_buffer.size(); j++)
+				{
+					const PxShape* shape = shape_buffer[j];
+					pose_table.shapes.push_back(shape);
+					pose_table.poses.push_back(PxShapeExt::getGlobalPose(*shape, *rigid_actor));
+					pose_table.geometries.push_back(shape->getGeometry());
+					pose_table.bounds.push_back(PxShapeExt::getWorldBounds(*shape, *rigid_actor));
+					local_poses.push_back(shape->getLocalPose());
+					if (shape->userData)
+						color_sources.push_back(((UserData*)shape->userData)->color);
+					else
+						color_sources.push_back(&default_color);
+				}
+			}
+		}
+
+		pose_table_dirty = false;
+		pose_table_layout++;
+	}
+
+	void Scene::UpdatePoseTable()
+	{
+		if (pose_table_dirty)
+		{
+			BuildPoseTable();
+			active_count = 0;
+			return;
+		}
+
+		//only the actors moved by the last step are visited, sleeping actors cost nothing
+#if PX_PHYSICS_VERSION < 0x304000 // SDK 3.3
+		const PxActiveTransform* active_transforms = px_scene->getActiveTransforms(active_count);
+#else
+		PxActor** active_actors = px_scene->getActiveActors(active_count);
+#endif
+
+		for (PxU32 i = 0; i < active_count; i++)
+		{
+#if PX_PHYSICS_VERSION < 0x304000 // SDK 3.3
+			const PxActor* actor = active_transforms[i].actor;
+			const PxTransform& actor_pose = active_transforms[i].actor2World;
+#else
+			const PxActor* actor = active_actors[i];
+			if (!actor->is<PxRigidActor>())
+				continue;
+			PxTransform actor_pose = ((const PxRigidActor*)actor)->getGlobalPose();
+#endif
+			std::unordered_map<const PxActor*, std::pair<PxU32, PxU32> >::const_iterator row = actor_rows.find(actor);
+			if (row == actor_rows.end())
+				continue;
+
+			PatchPoseTable(row->second, actor_pose);
+		}
+	}
+
+	void Scene::RefreshPoseTable()
+	{
+		if (pose_table_dirty)
+		{
+			BuildPoseTable();
+			return;
+		}
+
+		std::unordered_map<const PxActor*, std::pair<PxU32, PxU32> >::const_iterator row;
+		for (row = actor_rows.begin(); row != actor_rows.end(); row++)
+			PatchPoseTable(row->second, ((const PxRigidActor*)row->first)->getGlobalPose());
+	}
+
+	void Scene::PatchPoseTable(const std::pair<PxU32, PxU32>& rows, const PxTransform& actor_pose)
+	{
+		PxU32 end = rows.first + rows.second;
+		for (PxU32 j = rows.first; j < end; j++)
+		{
+			pose_table.poses[j] = actor_pose * local_poses[j];
+			pose_table.bounds[j] = PxGeometryQuery::getWorldBounds(pose_table.geometries[j].any(), pose_table.poses[j]);
+		}
+	}
+
+	void Scene::PublishSnapshot()
+	{
+		//actors may have been moved directly, e.g. while the simulation is paused
+		RefreshPoseTable();
+		CopySnapshot();
+	}
+
+	void Scene::CopySnapshot()
+	{
+		if (pose_table_dirty)
+			BuildPoseTable();
+
+		//the oldest snapshot is not read by anybody, the latest two may still be drawn
+		PxU32 back = (front_snapshot.load() + 1) % SNAPSHOT_COUNT;
+		RenderSnapshot& snapshot = snapshots[back];
+		snapshot.ClearCloths();
+
+		//rigid shapes: shapes and geometries only change with the set of actors, colours may have been changed by the user
+		if (snapshot_layouts[back] != pose_table_layout)
+		{
+			snapshot.shapes = pose_table.shapes;
+			snapshot.geometries = pose_table.geometries;
+			snapshot_layouts[back] = pose_table_layout;
+		}
+		snapshot.poses = pose_table.poses;
+		snapshot.bounds = pose_table.bounds;
+		snapshot.colors.resize(color_sources.size());
+		for (PxU32 i = 0; i < color_sources.size(); i++)
+			snapshot.colors[i] = *color_sources[i];
+
+		for (PxU32 i = 0; i < cloths.size(); i++)
+		{
+			PxCloth* cloth = cloths[i];
+			UserData* user_data = (UserData*)cloth->userData;
+
+			PxClothParticleData* particle_data = cloth->lockParticleData();
+			if (!particle_data)
+				continue;
+
+			PxU32 count = cloth->getNbParticles();
+			snapshot.cloth_first_particle.push_back((PxU32)snapshot.particles.size());
+			snapshot.cloth_particle_count.push_back(count);
+			for (PxU32 j = 0; j < count; j++)
+				snapshot.particles.push_back(particle_data->particles[j].pos);
+
+			particle_data->unlock();
 
-		px_scene->simulate(dt);
-		px_scene->fetchResults(true);
+			snapshot.cloth_poses.push_back(cloth->getGlobalPose());
+			snapshot.cloth_colors.push_back(*user_data->color);
+			snapshot.cloth_meshes.push_back(user_data->cloth_mesh_desc);
+		}
+
+		front_snapshot = back;
+	}
+
+	const RenderSnapshot& Scene::Snapshot()
+	{
+		return snapshots[front_snapshot.load()];
+	}
+
+	const RenderSnapshot& Scene::PreviousSnapshot()
+	{
+		return snapshots[(front_snapshot.load() + SNAPSHOT_COUNT - 1) % SNAPSHOT_COUNT];
+	}
+
+	PxU32 Scene::ActiveActors()
+	{
+		return active_count;
+	}
+
+	const PxSimulationStatistics& Scene::Statistics()
+	{
+		return statistics;
 	}
 
 	void Scene::Add(Actor* actor)
 	{
 		px_scene->addActor(*actor->Get());
+		pose_table_dirty = true;
 	}
 
 	void Scene::Remove(Actor* actor)
 	{
 		px_scene->removeActor(*actor->Get());
+		pose_table_dirty = true;
 	}
 
 	PxScene* Scene::Get() 
@@ -312,12 +725,83 @@ namespace PhysicsEngine
 		return px_scene; 
 	}
 
+	PxCpuDispatcher* Scene::Dispatcher()
+	{
+		return cpu_dispatcher;
+	}
+
+	void Scene::ApplyVisualization()
+	{
+		for (PxU32 i = 0; i < PxVisualizationParameter::eNUM_VALUES; i++)
+			px_scene->setVisualizationParameter((PxVisualizationParameter::Enum)i, visualization[i]);
+
+		//a zero scale turns off the generation of all debug geometry
+		px_scene->setVisualizationParameter(PxVisualizationParameter::eSCALE, show_visualization ? visualization[PxVisualizationParameter::eSCALE] : 0.f);
+		px_scene->setVisualizationCullingBox(visualization_box);
+	}
+
+	void Scene::Visualization(PxVisualizationParameter::Enum parameter, PxReal value)
+	{
+		visualization[parameter] = value;
+		if (px_scene)
+			ApplyVisualization();
+	}
+
+	PxReal Scene::Visualization(PxVisualizationParameter::Enum parameter)
+	{
+		return visualization[parameter];
+	}
+
+	void Scene::ToggleVisualization(PxVisualizationParameter::Enum parameter)
+	{
+		Visualization(parameter, (visualization[parameter] != 0.f) ? 0.f : 1.f);
+	}
+
+	void Scene::ShowVisualization(bool value)
+	{
+		show_visualization = value;
+		if (px_scene)
+			ApplyVisualization();
+	}
+
+	bool Scene::ShowVisualization()
+	{
+		return show_visualization;
+	}
+
+	void Scene::VisualizationCullingBox(const PxBounds3& box)
+	{
+		visualization_box = box;
+		if (px_scene)
+			px_scene->setVisualizationCullingBox(visualization_box);
+	}
+
 	void Scene::Reset()
 	{
-		px_scene->release();
+		Release();
 		Init();
 	}
 
+	void Scene::Release()
+	{
+		//a scene cannot be released in the middle of a step
+		CompleteStep();
+
+		if (px_scene)
+			px_scene->release();
+		px_scene = 0;
+
+		//the dispatcher has to outlive the scene that uses it
+		if (cpu_dispatcher)
+		{
+			if (dispatcher_type == WORK_STEALING_DISPATCHER)
+				((WorkStealingDispatcher*)cpu_dispatcher)->release();
+			else
+				((PxDefaultCpuDispatcher*)cpu_dispatcher)->release();
+		}
+		cpu_dispatcher = 0;
+	}
+
 	void Scene::Pause(bool value)
 	{
 		pause = value;
@@ -333,6 +817,16 @@ namespace PhysicsEngine
 		return selected_actor;
 	}
 
+	void Scene::SelectedActorForce(const PxVec3& force)
+	{
+		selected_force = force;
+	}
+
+	const PxVec3& Scene::SelectedActorForce()
+	{
+		return selected_force;
+	}
+
 	PxRigidDynamic* Scene::GetActor(int index)
 	{
 		std::vector<PxRigidDynamic*> actors(px_scene->getNbActors(PxActorTypeFlag::eRIGID_DYNAMIC)); // make buffer with size num of actors
@@ -349,7 +843,11 @@ namespace PhysicsEngine
 		std::vector<PxRigidDynamic*> actors(px_scene->getNbActors(PxActorTypeFlag::eRIGID_DYNAMIC));
 #endif
 		
-		selected_actor = actors[140];
+		//smaller scenes (e.g. benchmarks) do not have the container
+		if (actors.size() > 140)
+			selected_actor = actors[140];
+		else
+			selected_actor = 0;
 	}
 
 	std::vector<PxActor*> Scene::GetAllActors()
@@ -362,7 +860,8 @@ namespace PhysicsEngine
 			PxActorTypeFlag::eCLOTH;
 #endif
 		std::vector<PxActor*> actors(px_scene->getNbActors(selection_flag));
-		px_scene->getActors(selection_flag, (PxActor**)&actors.front(), (PxU32)actors.size());
+		if (actors.size())
+			px_scene->getActors(selection_flag, (PxActor**)&actors.front(), (PxU32)actors.size());
 		return actors;
 	}
 
@@ -1,11 +1,18 @@
 #pragma once
 
 #include <vector>
+#include <deque>
 #include "PxPhysicsAPI.h"
 #include "Exception.h"
-#include "Extras\UserData.h"
+#include "Extras/UserData.h"
+#include "Extras/RenderSnapshot.h"
+#include "WorkStealingDispatcher.h"
+#include "Profiler.h"
 #include <string>
 #include <iomanip>
+#include <thread>
+#include <atomic>
+#include <unordered_map>
 
 namespace PhysicsEngine
 {
@@ -30,6 +37,11 @@ namespace PhysicsEngine
 	///Create a new material
 	PxMaterial* CreateMaterial(PxReal sf=.0f, PxReal df=.0f, PxReal cr=.0f);
 
+	///Get a material with the specified properties, shared by all callers asking for the same ones.
+	///Shared materials should not be modified, create a new material instead.
+	PxMaterial* SharedMaterial(PxReal sf=.0f, PxReal df=.0f, PxReal cr=.0f,
+		PxCombineMode::Enum friction_mode=PxCombineMode::eAVERAGE, PxCombineMode::Enum restitution_mode=PxCombineMode::eAVERAGE);
+
 	static const PxVec3 default_color(.8f,.8f,.8f);
 
 	///Abstract Actor class
@@ -38,9 +50,15 @@ namespace PhysicsEngine
 	{
 	protected:
 		PxActor* actor;
-		std::vector<PxVec3> colors;
+		//shapes of the actor, in order of creation
+		std::vector<PxShape*> shapes;
+		//colour of each shape, a deque keeps the addresses passed to the renderer valid when it grows
+		std::deque<PxVec3> colors;
 		std::string name;
 
+		///Register a new shape and pass its colour to the renderer
+		void AddShape(PxShape* shape);
+
 	public:
 		///Constructor
 		Actor()
@@ -54,17 +72,20 @@ namespace PhysicsEngine
 
 		const PxVec3* Color(PxU32 shape_indx=0);
 
-		void Actor::Name(const string& name);
+		void Name(const string& name);
 
-		string Actor::Name();
+		string Name();
 
 		void Material(PxMaterial* new_material, PxU32 shape_index=-1);
 
 		PxShape* GetShape(PxU32 index=0);
 
-		std::vector<PxShape*> Actor::GetShapes(PxU32 index=-1);
+		std::vector<PxShape*> GetShapes(PxU32 index=-1);
 
 		virtual void CreateShape(const PxGeometry& geometry, PxReal density) {}
+
+		///Create several shapes at their local poses and update the mass properties once
+		void CreateShapes(const std::vector<PxGeometryHolder>& geometries, const std::vector<PxTransform>& local_poses, PxReal density, PxMaterial* material=0);
 	};
 
 	class DynamicActor : public Actor
@@ -92,24 +113,138 @@ namespace PhysicsEngine
 		void CreateShape(const PxGeometry& geometry, PxReal density=0.f);
 	};
 
+	///CPU dispatcher implementations
+	enum DispatcherType
+	{
+		DEFAULT_DISPATCHER,
+		WORK_STEALING_DISPATCHER
+	};
+
+	///Scene configuration, applied on Init and Reset
+	struct SceneConfig
+	{
+		//CPU dispatcher implementation
+		DispatcherType dispatcher;
+		//number of PhysX worker threads
+		PxU32 num_threads;
+		//optional affinity mask for each worker thread (empty = no affinity)
+		std::vector<PxU32> affinity_masks;
+		//step size used by Advance
+		PxReal fixed_dt;
+		//maximum number of steps performed by a single Advance call
+		PxU32 max_substeps;
+		//publish a render snapshot after every step
+		bool publish_snapshots;
+
+		///Default configuration: one worker per hardware thread, minus the main thread, 120Hz physics
+		SceneConfig()
+			: dispatcher(DEFAULT_DISPATCHER), num_threads(PxMax(std::thread::hardware_concurrency(), 2u) - 1),
+			fixed_dt(1.f/120.f), max_substeps(4), publish_snapshots(true)
+		{
+		}
+	};
+
 	///Generic scene class
 	class Scene
 	{
 	protected:
 		//a PhysX scene object
 		PxScene* px_scene;
+		//CPU dispatcher owned by the scene
+		PxCpuDispatcher* cpu_dispatcher;
+		//implementation of the dispatcher above
+		DispatcherType dispatcher_type;
+		//scene configuration
+		SceneConfig config;
 		//pause simulation
 		bool pause;
+		//a simulation step has been started and not completed yet
+		bool stepping;
+		//publish a snapshot when the running step completes
+		bool publish_step;
+		//real time not simulated yet
+		PxReal accumulator;
+		//interpolation factor between the last two steps
+		PxReal alpha;
+		//ring of render snapshots and the index of the latest one.
+		//The snapshot published before the latest one is drawn together with it, the third one is written by the next publish,
+		//so the pair being drawn survives the publish done while the next steps are started.
+		static const PxU32 SNAPSHOT_COUNT = 3;
+		RenderSnapshot snapshots[SNAPSHOT_COUNT];
+		std::atomic<PxU32> front_snapshot;
+		//current pose of every rigid shape, patched from the active actor list after every step
+		RenderSnapshot pose_table;
+		//local pose and colour source of every shape in the pose table
+		std::vector<PxTransform> local_poses;
+		std::vector<const PxVec3*> color_sources;
+		//first shape and number of shapes of every rigid actor in the pose table
+		std::unordered_map<const PxActor*, std::pair<PxU32, PxU32> > actor_rows;
+		//cloths are read in full on every publish
+		std::vector<PxCloth*> cloths;
+		//the set of actors changed since the pose table was built
+		bool pose_table_dirty;
+		//incremented by every build of the pose table, and the build each snapshot was copied from
+		PxU32 pose_table_layout;
+		PxU32 snapshot_layouts[SNAPSHOT_COUNT];
+		//number of actors moved by the last step
+		PxU32 active_count;
+		//statistics of the last step
+		PxSimulationStatistics statistics;
+		//duration of the running step
+		PhaseTimer step_timer;
+		//shape buffer reused when building the pose table
+		std::vector<PxShape*> shape_buffer;
+		//value of every visualization parameter, kept across resets
+		PxReal visualization[PxVisualizationParameter::eNUM_VALUES];
+		//debug geometry is only generated when shown
+		bool show_visualization;
+		//debug geometry is only generated inside this box (empty = everywhere)
+		PxBounds3 visualization_box;
+
+		//pass the visualization state to the PhysX scene
+		void ApplyVisualization();
+
+		//build the pose table from all actors in the scene
+		void BuildPoseTable();
+
+		//patch the pose table with the actors moved by the last step
+		void UpdatePoseTable();
+
+		//read the poses of all actors, used when actors may have been moved outside of a step
+		void RefreshPoseTable();
+
+		//set the poses and bounds of the shapes of a single actor
+		void PatchPoseTable(const std::pair<PxU32, PxU32>& rows, const PxTransform& actor_pose);
+
+		//copy the pose table and the cloths into the back snapshot and make it the latest one
+		void CopySnapshot();
 		//selected dynamic actor on the scene
 		PxRigidDynamic* selected_actor;
 		//original and modified colour of the selected actor
 		std::vector<PxVec3> sactor_color_orig;
+		//force applied to the selected actor at the start of every step
+		PxVec3 selected_force;
 
 		void HighlightOn(PxRigidDynamic* actor);
 
 		void HighlightOff(PxRigidDynamic* actor);
 
+		//release the PhysX scene and the dispatcher
+		void Release();
+
 	public:
+		///Constructor
+		Scene();
+
+		///Destructor
+		virtual ~Scene();
+
+		///Set the configuration, takes effect on the next Init or Reset
+		void Config(const SceneConfig& value);
+
+		///Get the configuration
+		const SceneConfig& Config();
+
 		///Init the scene
 		void Init();
 
@@ -119,6 +254,64 @@ namespace PhysicsEngine
 		///Perform a single simulation step
 		void Update(PxReal dt);
 
+		///Start a single simulation step without waiting for its results
+		void BeginStep(PxReal dt);
+
+		///Check if the step started by BeginStep has finished, never blocks
+		bool StepDone();
+
+		///Wait for the step started by BeginStep and apply its results (nothing to do if no step is running)
+		void CompleteStep();
+
+		///Is there a simulation step running
+		bool Stepping();
+
+		///Advance the simulation by the real frame time in fixed steps (SceneConfig::fixed_dt),
+		///the last step is left running and has to be finished with CompleteStep
+		void Advance(PxReal frame_time);
+
+		///Interpolation factor between the last two steps, the fraction of a fixed step left in the accumulator.
+		///Belongs to the snapshots published by the steps of the last Advance, read it together with them
+		///(e.g. after CompleteStep and before the next Advance): the rendered time is then one step behind.
+		PxReal Alpha();
+
+		///Copy the current state into the back snapshot and make it the latest one.
+		///Called after the steps that can be rendered, call it directly to show changes made while the simulation is paused
+		///(the poses of all actors are read again).
+		void PublishSnapshot();
+
+		///Get the latest snapshot, valid until the second following publish
+		const RenderSnapshot& Snapshot();
+
+		///Get the snapshot published before the latest one, valid until the next publish.
+		///Advance publishes at most once before it returns, so both snapshots can be drawn while its last step runs.
+		const RenderSnapshot& PreviousSnapshot();
+
+		///Number of actors moved by the last step
+		PxU32 ActiveActors();
+
+		///Statistics of the last completed step (bodies, constraints, pairs)
+		const PxSimulationStatistics& Statistics();
+
+		///Set a visualization parameter, eSCALE is only applied while the visualization is shown.
+		///Cannot be called while a step is running.
+		void Visualization(PxVisualizationParameter::Enum parameter, PxReal value);
+
+		///Get a visualization parameter
+		PxReal Visualization(PxVisualizationParameter::Enum parameter);
+
+		///Switch a visualization parameter between 0 and 1
+		void ToggleVisualization(PxVisualizationParameter::Enum parameter);
+
+		///Set show visualization, PhysX generates no debug geometry when hidden
+		void ShowVisualization(bool value);
+
+		///Get show visualization
+		bool ShowVisualization();
+
+		///Set the box debug geometry is generated in, an empty box disables culling
+		void VisualizationCullingBox(const PxBounds3& box);
+
 		///User defined update step
 		virtual void CustomUpdate() {}
 
@@ -129,6 +322,9 @@ namespace PhysicsEngine
 		///Get the PxScene object
 		PxScene* Get();
 
+		///Get the CPU dispatcher
+		PxCpuDispatcher* Dispatcher();
+
 		///Reset the scene
 		void Reset();
 
@@ -141,6 +337,12 @@ namespace PhysicsEngine
 		///Get the selected dynamic actor on the scene
 		PxRigidDynamic* GetSelectedActor();
 
+		///Set the force applied to the selected actor in every step, e.g. while a key is held
+		void SelectedActorForce(const PxVec3& force);
+
+		///Get the force applied to the selected actor in every step
+		const PxVec3& SelectedActorForce();
+
 		PxRigidDynamic* GetActor(int index);
 
 		///Switch to the next dynamic actor
@@ -0,0 +1,151 @@
+#pragma once
+
+#include "PxPhysicsAPI.h"
+#include <chrono>
+#include <algorithm>
+
+//define PHYSICS_PROFILING as 0 to compile all timers out
+#ifndef PHYSICS_PROFILING
+#define PHYSICS_PROFILING 1
+#endif
+
+namespace PhysicsEngine
+{
+	using namespace physx;
+
+	///Phases of a frame measured by the profiler
+	enum ProfilePhase
+	{
+		PHASE_CUSTOM_UPDATE,
+		//the simulate call only, the step itself runs on the workers
+		PHASE_SIMULATE,
+		PHASE_FETCH_RESULTS,
+		//a whole step, from the simulate call to the end of fetchResults
+		PHASE_STEP,
+		PHASE_PUBLISH,
+		PHASE_DEBUG_RENDER,
+		PHASE_RENDER,
+		PHASE_HUD,
+		PHASE_COUNT
+	};
+
+	///Summary of the recorded durations of a single phase, in milliseconds
+	struct PhaseStats
+	{
+		PxReal min;
+		PxReal avg;
+		PxReal p99;
+		PxU32 samples;
+
+		PhaseStats() : min(0.f), avg(0.f), p99(0.f), samples(0) {}
+	};
+
+	///Keeps the last HISTORY durations of every phase in a ring buffer.
+	///Timers are recorded from the main thread only.
+	class Profiler
+	{
+	public:
+		static const PxU32 HISTORY = 256;
+
+		///Record a single duration of a phase
+		static void Record(ProfilePhase phase, PxReal ms)
+		{
+			History& history = Get(phase);
+			history.samples[history.next] = ms;
+			history.next = (history.next + 1) % HISTORY;
+			history.count = PxMin(history.count + 1, HISTORY);
+		}
+
+		///Get min, average and 99th percentile of the recorded durations
+		static PhaseStats Stats(ProfilePhase phase)
+		{
+			PhaseStats stats;
+			History& history = Get(phase);
+			if (!history.count)
+				return stats;
+
+			PxReal sorted[HISTORY];
+			std::copy(history.samples, history.samples + history.count, sorted);
+			std::sort(sorted, sorted + history.count);
+
+			PxReal sum = 0.f;
+			for (PxU32 i = 0; i < history.count; i++)
+				sum += sorted[i];
+
+			stats.min = sorted[0];
+			stats.avg = sum / history.count;
+			stats.p99 = sorted[(history.count * 99) / 100];
+			stats.samples = history.count;
+			return stats;
+		}
+
+		///Get the name of a phase
+		static const char* Name(ProfilePhase phase)
+		{
+			static const char* names[PHASE_COUNT] = { "CustomUpdate", "simulate call", "fetchResults", "step", "snapshot", "debug render", "render", "hud" };
+			return names[phase];
+		}
+
+	private:
+		struct History
+		{
+			PxReal samples[HISTORY];
+			PxU32 next;
+			PxU32 count;
+		};
+
+		static History& Get(ProfilePhase phase)
+		{
+			static History histories[PHASE_COUNT] = {};
+			return histories[phase];
+		}
+	};
+
+	///Records the lifetime of a scope as a single duration of a phase
+	class ScopedTimer
+	{
+		ProfilePhase phase;
+		std::chrono::high_resolution_clock::time_point start;
+
+	public:
+		ScopedTimer(ProfilePhase _phase)
+			: phase(_phase), start(std::chrono::high_resolution_clock::now())
+		{
+		}
+
+		~ScopedTimer()
+		{
+			std::chrono::duration<PxReal, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+			Profiler::Record(phase, elapsed.count());
+		}
+	};
+
+	///Records a duration that starts and ends in different functions
+	class PhaseTimer
+	{
+		std::chrono::high_resolution_clock::time_point start;
+
+	public:
+		void Start()
+		{
+			start = std::chrono::high_resolution_clock::now();
+		}
+
+		void Stop(ProfilePhase phase)
+		{
+			std::chrono::duration<PxReal, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+			Profiler::Record(phase, elapsed.count());
+		}
+	};
+}
+
+///Time the rest of the enclosing scope, or between PROFILE_START and PROFILE_STOP of a PhaseTimer
+#if PHYSICS_PROFILING
+#define PROFILE_SCOPE(phase) PhysicsEngine::ScopedTimer scoped_timer(phase)
+#define PROFILE_START(timer) (timer).Start()
+#define PROFILE_STOP(timer, phase) (timer).Stop(phase)
+#else
+#define PROFILE_SCOPE(phase)
+#define PROFILE_START(timer)
+#define PROFILE_STOP(timer, phase)
+#endif
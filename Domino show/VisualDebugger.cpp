@@ -1,9 +1,20 @@
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <mmsystem.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
 #include "VisualDebugger.h"
 #include "BasicActors.h"
 #include <vector>
 #include "Extras\Camera.h"
 #include "Extras\Renderer.h"
 #include "Extras\HUD.h"
+#include "Extras\GLExtensions.h"
+#include <chrono>
+#include <thread>
+#include <cstdio>
 
 namespace VisualDebugger
 {
@@ -20,7 +31,9 @@ namespace VisualDebugger
 	{
 		EMPTY = 0,
 		HELP = 1,
-		PAUSE = 2
+		PAUSE = 2,
+		PROFILE = 3,
+		STATS = 4
 	};
 
 	//function declarations
@@ -32,21 +45,46 @@ namespace VisualDebugger
 	void motionCallback(int x, int y);
 	void mouseCallback(int button, int state, int x, int y);
 	void exitCallback(void);
+	void idleCallback(void);
+	void FramePacing(bool value);
 
 	void RenderScene();
 	void ToggleRenderMode();
+	void ToggleVisualization(unsigned char key);
 	void HUDInit();
+	void HUDProfile();
+	void HUDStats();
 
 	///simulation objects
 	Camera* camera;
 	PhysicsEngine::MyScene* scene;
+	//step of the mouse look, mouse deltas do not depend on the frame time
 	PxReal delta_time = 1.f/60.f;
+	//measured length of the current frame, moves the camera; longer frames (e.g. after a stall) are clamped
+	PxReal frame_delta = 1.f/60.f;
+	PxReal max_frame_delta = .1f;
 	PxReal gForceStrength = 100;
 	RenderMode render_mode = NORMAL;
+	//debug geometry is only generated up to this distance from the camera
+	PxReal debug_distance = 100.f;
 	const int MAX_KEYS = 256;
 	bool key_state[MAX_KEYS];
 	bool hud_show = true;
+	//screen shown when not paused: help, profiler or statistics
+	HUDState info_screen = HELP;
+	//average frame time in seconds
+	PxReal frame_average = 1.f/60.f;
 	HUD hud;
+	//time of the previous frame, used to feed the real frame time to the simulation
+	std::chrono::high_resolution_clock::time_point last_frame;
+	//redraws are paced to target_fps (paused_fps while paused), without pacing frames are drawn as fast as possible
+	bool frame_pacing = true;
+	PxReal target_fps = 60.f;
+	PxReal paused_fps = 10.f;
+	//closer to the next frame than this the idle callback yields instead of sleeping, in seconds
+	PxReal sleep_margin = .002f;
+	//time of the last redraw request
+	std::chrono::high_resolution_clock::time_point last_redisplay;
 
 	//Init the debugger
 	void Init(const char *window_name, int width, int height)
@@ -55,6 +93,7 @@ namespace VisualDebugger
 		PhysicsEngine::PxInit();
 		scene = new PhysicsEngine::MyScene();
 		scene->Init();
+		scene->ShowVisualization(render_mode != NORMAL);
 
 		///Init renderer
 		Renderer::BackgroundColor(PxVec3(150.f/255.f,150.f/255.f,150.f/255.f));
@@ -62,6 +101,12 @@ namespace VisualDebugger
 		Renderer::InitWindow(window_name, width, height);
 		Renderer::Init();
 
+#ifdef _WIN32
+		//sleep with millisecond resolution instead of the default 15 ms
+		timeBeginPeriod(1);
+#endif
+		FramePacing(frame_pacing);
+
 		camera = new Camera(PxVec3(03.0f, 7.0f, 20.0f), PxVec3(0.f,-.1f,-1.f), 2.f); // final value is speed
 
 		//initialise HUD
@@ -70,6 +115,7 @@ namespace VisualDebugger
 		///Assign callbacks
 		//render
 		glutDisplayFunc(RenderScene);
+		glutIdleFunc(idleCallback);
 
 		//keyboard
 		glutKeyboardFunc(KeyPress);
@@ -85,6 +131,9 @@ namespace VisualDebugger
 
 		//init motion callback
 		motionCallback(0,0);
+
+		last_frame = std::chrono::high_resolution_clock::now();
+		last_redisplay = last_frame;
 	}
 
 	void HUDInit()
@@ -99,9 +148,12 @@ namespace VisualDebugger
 		hud.AddLine(HELP, "    F12 - reset");
 		hud.AddLine(HELP, "");
 		hud.AddLine(HELP, " Display");
+		hud.AddLine(HELP, "    F4 - frame pacing on/off (off = no vsync, as fast as possible)");
 		hud.AddLine(HELP, "    F5 - help on/off");
 		hud.AddLine(HELP, "    F6 - shadows on/off");
 		hud.AddLine(HELP, "    F7 - render mode");
+		hud.AddLine(HELP, "    F11 - help/profiler/statistics");
+		hud.AddLine(HELP, "    1,2,3,4,5 - debug shapes,contacts,bounds,body axes,joints");
 		hud.AddLine(HELP, "");
 		hud.AddLine(HELP, " Camera");
 		hud.AddLine(HELP, "    W,S,A,D,Q,Z - forward,backward,left,right,up,down");
@@ -119,37 +171,142 @@ namespace VisualDebugger
 		hud.AddLine(PAUSE, "");
 		hud.AddLine(PAUSE, "");
 		hud.AddLine(PAUSE, "   Simulation paused. Press F10 to continue.");
+		//add a profiler screen, filled in by HUDProfile
+		hud.AddLine(PROFILE, "");
+		//add a statistics screen, filled in by HUDStats
+		hud.AddLine(STATS, "");
 		//set font size for all screens
 		hud.FontSize(0.018f);
 		//set font color for all screens
 		hud.Color(PxVec3(0.f,0.f,0.f));
 	}
 
+	//Refresh the profiler screen with the recorded phase timings
+	void HUDProfile()
+	{
+		//refresh a few times per second so the numbers are readable
+		static int frame = 0;
+		if (frame++ % 15)
+			return;
+
+		char line[128];
+		unsigned int n = 0;
+
+		hud.SetLine(PROFILE, n++, " Profiler (last 256 samples, ms)");
+#if PHYSICS_PROFILING
+		hud.SetLine(PROFILE, n++, "    phase            min      avg      p99");
+		for (int i = 0; i < PhysicsEngine::PHASE_COUNT; i++)
+		{
+			PhysicsEngine::PhaseStats stats = PhysicsEngine::Profiler::Stats((PhysicsEngine::ProfilePhase)i);
+			snprintf(line, sizeof(line), "    %-14s %7.3f  %7.3f  %7.3f", PhysicsEngine::Profiler::Name((PhysicsEngine::ProfilePhase)i),
+				stats.min, stats.avg, stats.p99);
+			hud.SetLine(PROFILE, n++, line);
+		}
+#else
+		hud.SetLine(PROFILE, n++, "    disabled (PHYSICS_PROFILING=0)");
+#endif
+		hud.SetLine(PROFILE, n++, "");
+		snprintf(line, sizeof(line), "    awake bodies: %u", scene->Statistics().nbActiveDynamicBodies);
+		hud.SetLine(PROFILE, n++, line);
+	}
+
+	//Refresh the statistics screen with the last step of the scene and the frame timings
+	//lines are formatted into a fixed buffer and copied into the existing HUD lines
+	void HUDStats()
+	{
+		static int frame = 0;
+		if (frame++ % 15)
+			return;
+
+		const PxSimulationStatistics& stats = scene->Statistics();
+		char line[128];
+		unsigned int n = 0;
+
+		hud.SetLine(STATS, n++, " Statistics (last step)");
+		snprintf(line, sizeof(line), "    frame: %6.2f ms (%.0f fps)", frame_average * 1000.f, 1.f / PxMax(frame_average, 1e-6f));
+		hud.SetLine(STATS, n++, line);
+#if PHYSICS_PROFILING
+		PxReal step = PhysicsEngine::Profiler::Stats(PhysicsEngine::PHASE_STEP).avg;
+		PxReal simulate = PhysicsEngine::Profiler::Stats(PhysicsEngine::PHASE_SIMULATE).avg;
+		PxReal fetch = PhysicsEngine::Profiler::Stats(PhysicsEngine::PHASE_FETCH_RESULTS).avg;
+		snprintf(line, sizeof(line), "    step: %6.2f ms (simulate call %.2f, fetchResults %.2f)", step, simulate, fetch);
+#else
+		snprintf(line, sizeof(line), "    step: disabled (PHYSICS_PROFILING=0)");
+#endif
+		hud.SetLine(STATS, n++, line);
+		hud.SetLine(STATS, n++, "");
+		snprintf(line, sizeof(line), "    dynamic bodies: %u (%u active)", stats.nbDynamicBodies, stats.nbActiveDynamicBodies);
+		hud.SetLine(STATS, n++, line);
+		snprintf(line, sizeof(line), "    static bodies: %u", stats.nbStaticBodies);
+		hud.SetLine(STATS, n++, line);
+		snprintf(line, sizeof(line), "    active constraints: %u", stats.nbActiveConstraints);
+		hud.SetLine(STATS, n++, line);
+		snprintf(line, sizeof(line), "    broadphase pairs: +%u -%u", stats.nbNewPairs, stats.nbLostPairs);
+		hud.SetLine(STATS, n++, line);
+		snprintf(line, sizeof(line), "    contact pairs: %u (%u touching)", stats.nbDiscreteContactPairsTotal, stats.nbDiscreteContactPairsWithContacts);
+		hud.SetLine(STATS, n++, line);
+		snprintf(line, sizeof(line), "    touches: +%u -%u", stats.nbNewTouches, stats.nbLostTouches);
+		hud.SetLine(STATS, n++, line);
+		snprintf(line, sizeof(line), "    solver partitions: %u", stats.nbPartitions);
+		hud.SetLine(STATS, n++, line);
+	}
+
 	//Start the main loop
 	void Start()
 	{ 
 		glutMainLoop(); 
 	}
 
-	//Render the scene and perform a single simulation step
+	//Render the scene and advance the simulation
+	//The snapshots of the steps completed so far are taken first, then the next steps are started and the scene is
+	//drawn while the last of them runs: PhysX overlaps the main draw, the HUD and the buffer swap. The running step is
+	//completed in the next frame, so the rendered state always lags the simulated time by exactly one fixed step.
 	void RenderScene()
 	{
+		//apply the results of the step started in the previous frame
+		scene->CompleteStep();
+
+		//the real frame time, used by the camera and to advance the simulation
+		std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+		std::chrono::duration<PxReal> frame_time = now - last_frame;
+		last_frame = now;
+		frame_average += (frame_time.count() - frame_average) * .05f;
+		frame_delta = PxMin(frame_time.count(), max_frame_delta);
+
 		//handle pressed keys
 		KeyHold();
 
+		//no steps are running while paused, publish the changes made by the user
+		if (scene->Pause())
+			scene->PublishSnapshot();
+
 		//start rendering
 		Renderer::Start(camera->getEye(), camera->getDir());
 
+		//limit the debug geometry of the next step to what the camera can see
+		if (render_mode != NORMAL)
+			scene->VisualizationCullingBox(Renderer::ViewBounds(debug_distance));
+
+		//the debug render buffer is only valid between steps
 		if ((render_mode == DEBUG) || (render_mode == BOTH))
 		{
+			PROFILE_SCOPE(PhysicsEngine::PHASE_DEBUG_RENDER);
 			Renderer::Render(scene->Get()->getRenderBuffer());
 		}
 
+		//the last two completed steps, alpha was computed by the Advance that started them;
+		//both stay valid through the publish Advance may do, see Scene::PreviousSnapshot
+		const RenderSnapshot& snapshot = scene->Snapshot();
+		const RenderSnapshot& previous = scene->PreviousSnapshot();
+		PxReal alpha = scene->Alpha();
+
+		//advance the simulation by the real frame time in fixed steps, the last one runs until the next frame
+		scene->Advance(frame_time.count());
+
 		if ((render_mode == NORMAL) || (render_mode == BOTH))
 		{
-			std::vector<PxActor*> actors = scene->GetAllActors();
-			if (actors.size())
-				Renderer::Render(&actors[0], (PxU32)actors.size());
+			PROFILE_SCOPE(PhysicsEngine::PHASE_RENDER);
+			Renderer::Render(snapshot, previous, alpha);
 		}
 
 		//adjust the HUD state
@@ -158,19 +315,25 @@ namespace VisualDebugger
 			if (scene->Pause())
 				hud.ActiveScreen(PAUSE);
 			else
-				hud.ActiveScreen(HELP);
+			{
+				if (info_screen == PROFILE)
+					HUDProfile();
+				else if (info_screen == STATS)
+					HUDStats();
+				hud.ActiveScreen(info_screen);
+			}
 		}
 		else
 			hud.ActiveScreen(EMPTY);
 
 		//render HUD
-		hud.Render();
+		{
+			PROFILE_SCOPE(PhysicsEngine::PHASE_HUD);
+			hud.Render();
+		}
 
 		//finish rendering
 		Renderer::Finish();
-
-		//perform a single simulation step
-		scene->Update(delta_time);
 	}
 
 	//user defined keyboard handlers
@@ -215,29 +378,29 @@ namespace VisualDebugger
 		switch (toupper(key))
 		{
 		case 'W':
-			camera->MoveForward(delta_time);
+			camera->MoveForward(frame_delta);
 			break;
 		case 'S':
-			camera->MoveBackward(delta_time);
+			camera->MoveBackward(frame_delta);
 			break;
 		case 'A':
-			camera->MoveLeft(delta_time);
+			camera->MoveLeft(frame_delta);
 			break;
 		case 'D':
-			camera->MoveRight(delta_time);
+			camera->MoveRight(frame_delta);
 			break;
 		case 'Q':
-			camera->MoveUp(delta_time);
+			camera->MoveUp(frame_delta);
 			break;
 		case 'Z':
-			camera->MoveDown(delta_time);
+			camera->MoveDown(frame_delta);
 			break;
 		default:
 			break;
 		}
 	}
 
-	//handle force control keys
+	//handle force control keys, the forces of all held keys are applied in every simulation step
 	void ForceInput(int key)
 	{
 		if (!scene->GetSelectedActor())
@@ -247,22 +410,22 @@ namespace VisualDebugger
 		{
 			 //Force controls on the selected actor
 		case 'I': //forward
-			scene->GetSelectedActor()->addForce(PxVec3(0, 0, -1) * gForceStrength);
+			scene->SelectedActorForce(scene->SelectedActorForce() + PxVec3(0, 0, -1)*gForceStrength);
 			break;
 		case 'K': //backward
-			scene->GetSelectedActor()->addForce(PxVec3(0,0,1)*gForceStrength);
+			scene->SelectedActorForce(scene->SelectedActorForce() + PxVec3(0,0,1)*gForceStrength);
 			break;
 		case 'J': //left
-			scene->GetSelectedActor()->addForce(PxVec3(-1,0,0)*gForceStrength);
+			scene->SelectedActorForce(scene->SelectedActorForce() + PxVec3(-1,0,0)*gForceStrength);
 			break;
 		case 'L': //right
-			scene->GetSelectedActor()->addForce(PxVec3(1,0,0)*gForceStrength);  ////// We don't want to apply forces to any actors.
+			scene->SelectedActorForce(scene->SelectedActorForce() + PxVec3(1,0,0)*gForceStrength);
 			break;
 		case 'U': //up
-			scene->GetSelectedActor()->addForce(PxVec3(0,1,0)*gForceStrength);  ////// TODO maybe delete all of these that we don't need!
+			scene->SelectedActorForce(scene->SelectedActorForce() + PxVec3(0,1,0)*gForceStrength);
 			break;
 		case 'M': //down
-			scene->GetSelectedActor()->addForce(PxVec3(0,-1,0)*gForceStrength);
+			scene->SelectedActorForce(scene->SelectedActorForce() + PxVec3(0,-1,0)*gForceStrength);
 			break;
 		case 'P':
 		//	scene->SelectNextActor();
@@ -275,10 +438,17 @@ namespace VisualDebugger
 	///handle special keys
 	void KeySpecial(int key, int x, int y)
 	{
+		//the scene cannot be modified while a step is running
+		scene->CompleteStep();
+
 		//simulation control
 		switch (key)
 		{
 			//display control
+		case GLUT_KEY_F4:
+			//frame pacing on/off
+			FramePacing(!frame_pacing);
+			break;
 		case GLUT_KEY_F5:
 			//hud on/off
 			hud_show = !hud_show;
@@ -295,6 +465,15 @@ namespace VisualDebugger
 			//reset camera view
 			camera->Reset();
 			break;
+		case GLUT_KEY_F11:
+			//cycle help, profiler and statistics
+			if (info_screen == HELP)
+				info_screen = PROFILE;
+			else if (info_screen == PROFILE)
+				info_screen = STATS;
+			else
+				info_screen = HELP;
+			break;
 
 			//simulation control
 		case GLUT_KEY_F9:
@@ -327,6 +506,10 @@ namespace VisualDebugger
 		if (key == 27)
 			exit(0);
 
+		//the scene cannot be modified while a step is running
+		scene->CompleteStep();
+
+		ToggleVisualization(key);
 		UserKeyPress(key);
 	}
 
@@ -340,6 +523,8 @@ namespace VisualDebugger
 	//handle holded keys
 	void KeyHold()
 	{
+		scene->SelectedActorForce(PxVec3(0.f));
+
 		for (int i = 0; i < MAX_KEYS; i++)
 		{
 			if (key_state[i]) // if key down
@@ -380,11 +565,90 @@ namespace VisualDebugger
 			render_mode = BOTH;
 		else if (render_mode == BOTH)
 			render_mode = NORMAL;
+
+		//no debug geometry is generated when it is not drawn
+		scene->ShowVisualization(render_mode != NORMAL);
+	}
+
+	//toggle the categories of debug geometry with the number keys
+	void ToggleVisualization(unsigned char key)
+	{
+		switch (key)
+		{
+		case '1':
+			scene->ToggleVisualization(PxVisualizationParameter::eCOLLISION_SHAPES);
+			break;
+		case '2':
+			scene->ToggleVisualization(PxVisualizationParameter::eCONTACT_POINT);
+			scene->Visualization(PxVisualizationParameter::eCONTACT_NORMAL, scene->Visualization(PxVisualizationParameter::eCONTACT_POINT));
+			break;
+		case '3':
+			scene->ToggleVisualization(PxVisualizationParameter::eCOLLISION_AABBS);
+			break;
+		case '4':
+			scene->ToggleVisualization(PxVisualizationParameter::eBODY_AXES);
+			break;
+		case '5':
+			scene->ToggleVisualization(PxVisualizationParameter::eJOINT_LOCAL_FRAMES);
+			scene->Visualization(PxVisualizationParameter::eJOINT_LIMITS, scene->Visualization(PxVisualizationParameter::eJOINT_LOCAL_FRAMES));
+			break;
+		default:
+			break;
+		}
+	}
+
+	///Set frame pacing, uncapped frames also turn off vsync where the driver allows it
+	void FramePacing(bool value)
+	{
+		frame_pacing = value;
+		GLExtensions::SwapInterval(frame_pacing ? 1 : 0);
+	}
+
+	///idle callback, requests a redraw when the next frame is due
+	///far from it the thread sleeps so the PhysX workers and other processes get the CPU, close to it the thread only yields
+	void idleCallback(void)
+	{
+		std::chrono::high_resolution_clock::time_point now = std::chrono::high_resolution_clock::now();
+
+		//a paused scene is still redrawn for the camera and the HUD, just less often
+		if (frame_pacing || scene->Pause())
+		{
+			PxReal fps = scene->Pause() ? paused_fps : target_fps;
+			std::chrono::duration<PxReal> period(1.f / fps);
+			std::chrono::duration<PxReal> remaining = period - (now - last_redisplay);
+
+			//sleep in short slices so GLUT keeps handling input in between
+			if (remaining.count() > sleep_margin)
+			{
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				return;
+			}
+			if (remaining.count() > 0.f)
+			{
+				std::this_thread::yield();
+				return;
+			}
+
+			//frames are due at fixed intervals, so oversleeping once does not delay all following frames
+			last_redisplay += std::chrono::duration_cast<std::chrono::high_resolution_clock::duration>(period);
+			//more than a frame behind (slow frames, changed rate): start over from now instead of catching up
+			if (now - last_redisplay > period)
+				last_redisplay = now;
+		}
+		else
+			last_redisplay = now;
+
+		glutPostRedisplay();
 	}
 
 	///exit callback
 	void exitCallback(void)
 	{
+#ifdef _WIN32
+		timeEndPeriod(1);
+#endif
+
+		Renderer::Release();
 		delete camera;
 		delete scene;
 		PhysicsEngine::PxRelease();
@@ -0,0 +1,181 @@
+#include "WorkStealingDispatcher.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace PhysicsEngine
+{
+	using namespace physx;
+
+	//the pool and worker index of the calling thread (0 for threads outside of any pool)
+	static thread_local WorkStealingDispatcher* current_pool = 0;
+	static thread_local PxU32 current_worker = 0;
+
+	//pin a thread to the cores selected by the mask
+	static void SetAffinity(std::thread& thread, PxU32 mask)
+	{
+		if (!mask)
+			return;
+#ifdef _WIN32
+		SetThreadAffinityMask(thread.native_handle(), (DWORD_PTR)mask);
+#else
+		cpu_set_t cpu_set;
+		CPU_ZERO(&cpu_set);
+		for (PxU32 i = 0; i < 32; i++)
+		{
+			if (mask & (1u << i))
+				CPU_SET(i, &cpu_set);
+		}
+		pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set), &cpu_set);
+#endif
+	}
+
+	WorkStealingDispatcher* WorkStealingDispatcher::Create(PxU32 num_threads, const PxU32* affinity_masks)
+	{
+		return new WorkStealingDispatcher(num_threads, affinity_masks);
+	}
+
+	void WorkStealingDispatcher::release()
+	{
+		delete this;
+	}
+
+	WorkStealingDispatcher::WorkStealingDispatcher(PxU32 num_threads, const PxU32* affinity_masks)
+		: queued(0), sleeping(0), next_worker(0), quit(false)
+	{
+		//create all queues before any worker starts stealing from them
+		for (PxU32 i = 0; i < num_threads; i++)
+			workers.push_back(new Worker());
+
+		for (PxU32 i = 0; i < num_threads; i++)
+		{
+			workers[i]->thread = std::thread(&WorkStealingDispatcher::Run, this, i);
+			if (affinity_masks)
+				SetAffinity(workers[i]->thread, affinity_masks[i]);
+		}
+	}
+
+	WorkStealingDispatcher::~WorkStealingDispatcher()
+	{
+		{
+			std::lock_guard<std::mutex> guard(sleep_lock);
+			quit = true;
+		}
+		wake.notify_all();
+
+		//the queues can only go once no worker is able to steal from them
+		for (PxU32 i = 0; i < workers.size(); i++)
+			workers[i]->thread.join();
+
+		for (PxU32 i = 0; i < workers.size(); i++)
+			delete workers[i];
+	}
+
+	void WorkStealingDispatcher::submitTask(PxBaseTask& task)
+	{
+		//no workers: run the task on the submitting thread
+		if (workers.empty())
+		{
+			Execute(&task);
+			return;
+		}
+
+		//tasks spawned inside the pool stay on the local queue, the rest is spread round robin
+		PxU32 index;
+		if (current_pool == this)
+			index = current_worker;
+		else
+			index = next_worker++ % (PxU32)workers.size();
+
+		//counted under the queue lock after the push, so a worker that sees it queued can also pop it
+		{
+			std::lock_guard<std::mutex> guard(workers[index]->lock);
+			workers[index]->queue.push_back(&task);
+			queued++;
+		}
+
+		//only pay for the wake up when somebody is actually waiting
+		if (sleeping.load() > 0)
+		{
+			std::lock_guard<std::mutex> guard(sleep_lock);
+			wake.notify_one();
+		}
+	}
+
+	PxU32 WorkStealingDispatcher::getWorkerCount() const
+	{
+		return (PxU32)workers.size();
+	}
+
+	bool WorkStealingDispatcher::Pop(PxU32 index, PxBaseTask*& task)
+	{
+		std::lock_guard<std::mutex> guard(workers[index]->lock);
+		if (workers[index]->queue.empty())
+			return false;
+
+		task = workers[index]->queue.back();
+		workers[index]->queue.pop_back();
+		queued--;
+		return true;
+	}
+
+	bool WorkStealingDispatcher::Steal(PxU32 thief, PxBaseTask*& task)
+	{
+		PxU32 count = (PxU32)workers.size();
+		for (PxU32 i = 1; i <= count; i++)
+		{
+			Worker* victim = workers[(thief + i) % count];
+
+			//skip contended queues instead of waiting on them
+			std::unique_lock<std::mutex> guard(victim->lock, std::try_to_lock);
+			if (!guard.owns_lock() || victim->queue.empty())
+				continue;
+
+			task = victim->queue.front();
+			victim->queue.pop_front();
+			queued--;
+			return true;
+		}
+
+		return false;
+	}
+
+	void WorkStealingDispatcher::Execute(PxBaseTask* task)
+	{
+		task->run();
+		task->release();
+	}
+
+	void WorkStealingDispatcher::Run(PxU32 index)
+	{
+		current_pool = this;
+		current_worker = index;
+
+		PxBaseTask* task;
+		while (true)
+		{
+			if (Pop(index, task) || Steal(index, task))
+			{
+				Execute(task);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> guard(sleep_lock);
+			if (quit)
+				return;
+
+			//check the queues once more after announcing the sleep, see Push
+			sleeping++;
+			wake.wait(guard, [this] { return quit || (queued.load() > 0); });
+			sleeping--;
+
+			if (quit)
+				return;
+		}
+	}
+}
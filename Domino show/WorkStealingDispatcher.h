@@ -0,0 +1,60 @@
+#pragma once
+
+#include "PxPhysicsAPI.h"
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace PhysicsEngine
+{
+	using namespace physx;
+
+	///A PxCpuDispatcher backed by a pool of workers with local queues and work stealing.
+	///Workers pop their own queue from the back and steal from the front of the others,
+	///so tasks spawned by a task stay on the same worker and there is no shared queue to contend on.
+	class WorkStealingDispatcher : public PxCpuDispatcher
+	{
+	public:
+		///Create a dispatcher with the specified number of workers and optional affinity masks (one per worker)
+		static WorkStealingDispatcher* Create(PxU32 num_threads, const PxU32* affinity_masks=0);
+
+		///Stop the workers and delete the dispatcher
+		void release();
+
+		///PxCpuDispatcher interface, called by PhysX
+		virtual void submitTask(PxBaseTask& task);
+
+		///PxCpuDispatcher interface, called by PhysX
+		virtual PxU32 getWorkerCount() const;
+
+	private:
+		struct Worker
+		{
+			std::mutex lock;
+			std::deque<PxBaseTask*> queue;
+			std::thread thread;
+		};
+
+		std::vector<Worker*> workers;
+		//number of queued tasks over all workers
+		std::atomic<PxU32> queued;
+		//number of workers waiting for work
+		std::atomic<PxU32> sleeping;
+		//round robin target for submissions from outside of the pool
+		std::atomic<PxU32> next_worker;
+		bool quit;
+		std::mutex sleep_lock;
+		std::condition_variable wake;
+
+		WorkStealingDispatcher(PxU32 num_threads, const PxU32* affinity_masks);
+		~WorkStealingDispatcher();
+
+		bool Pop(PxU32 index, PxBaseTask*& task);
+		bool Steal(PxU32 thief, PxBaseTask*& task);
+		void Execute(PxBaseTask* task);
+		void Run(PxU32 index);
+	};
+}
@@ -0,0 +1,380 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include "MyPhysicsEngine.h"
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <cstdio>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace physx;
+
+namespace PhysicsEngine
+{
+	///A scene with a single straight chain of dominos on the ground plane
+	class BenchScene : public MyScene
+	{
+		Plane* plane;
+
+	public:
+		PxU32 domino_count;
+
+		BenchScene(PxU32 count) : plane(0), domino_count(count) {}
+
+		///Release the actors, the scene itself only releases the PxScene
+		virtual ~BenchScene()
+		{
+			CompleteStep();
+
+			for (PxU32 i = 0; i < dominos.size(); i++)
+				ReleaseActor(dominos[i]);
+			dominos.clear();
+
+			if (plane)
+				ReleaseActor(plane);
+			plane = 0;
+		}
+
+		virtual void CustomInit()
+		{
+			dominos.clear();
+
+			plane = new Plane();
+			Add(plane);
+
+			//createDominos creates amount+1 dominos, standing on the plane
+			createDominos(PxVec3(0.f, 0.0254f, 0.f), 0.f, (int)domino_count - 1);
+		}
+
+		virtual void CustomUpdate() {}
+
+		///Knock over the first domino
+		void Trigger()
+		{
+			PxRigidDynamic* first = (PxRigidDynamic*)dominos.front()->Get();
+			PxRigidBodyExt::addForceAtLocalPos(*first, PxVec3(.5f, 0.f, 0.f), PxVec3(0.f, .02f, 0.f), PxForceMode::eVELOCITY_CHANGE);
+		}
+
+		///Delete the wrapper (and the user data of its shapes) and then the PhysX actor
+		template<class ActorType>
+		static void ReleaseActor(ActorType* actor)
+		{
+			PxActor* px_actor = actor->Get();
+			delete actor;
+			px_actor->release();
+		}
+
+		///Has the domino tipped over by more than 45 degrees
+		static bool Fallen(Domino* domino)
+		{
+			PxTransform pose = ((PxRigidActor*)domino->Get())->getGlobalPose();
+			return pose.q.rotate(PxVec3(0.f, 1.f, 0.f)).y < 0.7071f;
+		}
+	};
+}
+
+///Options of the benchmark
+struct BenchOptions
+{
+	//chain lengths to measure
+	std::vector<PxU32> sizes;
+	//simulation step size
+	PxReal dt;
+	//simulated time limit of a single run, 0 = scaled with the chain length
+	PxReal max_time;
+	//a run stops once no body has been awake for this long (the wave died out)
+	PxReal idle_time;
+	//output format: csv or json
+	string format;
+	//output file, empty = standard output
+	string output;
+	//scene configuration (worker threads)
+	PhysicsEngine::SceneConfig config;
+	//directory of cooked mesh files, empty = cook every run
+	string mesh_cache;
+
+	BenchOptions() : dt(1.f/120.f), max_time(0.f), idle_time(1.f), format("csv")
+	{
+		sizes.push_back(100);
+		sizes.push_back(1000);
+		sizes.push_back(10000);
+		sizes.push_back(50000);
+		//nothing is rendered
+		config.publish_snapshots = false;
+	}
+};
+
+///Result of a single run
+struct BenchResult
+{
+	PxU32 dominos;
+	PxU32 steps;
+	double ms_per_step;
+	//resident memory the run added to the process, peak during the run minus the memory before it
+	double memory_mb;
+	//simulated time until the last domino fell, negative if it did not fall (time limit or the wave stopped)
+	PxReal time_to_last_fall;
+	PxU32 fallen;
+};
+
+//resident memory of the process right now, in megabytes
+double ResidentMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.WorkingSetSize / (1024. * 1024.);
+	return 0.;
+#else
+	//the second field of statm is the resident size in pages
+	long size = 0, resident = 0;
+	FILE* statm = fopen("/proc/self/statm", "r");
+	if (!statm)
+		return 0.;
+	if (fscanf(statm, "%ld %ld", &size, &resident) != 2)
+		resident = 0;
+	fclose(statm);
+	return resident * (double)sysconf(_SC_PAGESIZE) / (1024. * 1024.);
+#endif
+}
+
+void PrintUsage(const char* program)
+{
+	cerr << "Usage: " << program << " [options]" << endl;
+	cerr << "    --sizes N,N,...   chain lengths (default 100,1000,10000,50000)" << endl;
+	cerr << "    --dt SECONDS      simulation step size (default 1/120)" << endl;
+	cerr << "    --max-time T      simulated time limit of a run (default 60 + 0.2 per domino)" << endl;
+	cerr << "    --idle-time T     stop a run when no body was awake for T seconds (default 1)" << endl;
+	cerr << "    --threads N       number of PhysX worker threads (default hardware threads - 1)" << endl;
+	cerr << "    --dispatcher NAME default or stealing (default default)" << endl;
+	cerr << "    --format FORMAT   csv or json (default csv)" << endl;
+	cerr << "    --out FILE        output file (default standard output)" << endl;
+	cerr << "    --mesh-cache DIR  keep cooked meshes in DIR for later runs (default off)" << endl;
+}
+
+//parse the command line, returns false if the program should exit
+bool ParseOptions(int argc, char* argv[], BenchOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : 0;
+
+		if (!strcmp(arg, "--help") || !strcmp(arg, "-h"))
+			return false;
+
+		if (!value)
+		{
+			cerr << "Missing value for " << arg << endl;
+			return false;
+		}
+
+		if (!strcmp(arg, "--sizes"))
+		{
+			options.sizes.clear();
+			stringstream list(value);
+			string size;
+			while (getline(list, size, ','))
+			{
+				PxU32 count = (PxU32)strtoul(size.c_str(), 0, 10);
+				if (count)
+					options.sizes.push_back(count);
+			}
+		}
+		else if (!strcmp(arg, "--dt"))
+			options.dt = (PxReal)atof(value);
+		else if (!strcmp(arg, "--max-time"))
+			options.max_time = (PxReal)atof(value);
+		else if (!strcmp(arg, "--idle-time"))
+			options.idle_time = (PxReal)atof(value);
+		else if (!strcmp(arg, "--threads"))
+			options.config.num_threads = (PxU32)strtoul(value, 0, 10);
+		else if (!strcmp(arg, "--dispatcher"))
+		{
+			if (!strcmp(value, "default"))
+				options.config.dispatcher = PhysicsEngine::DEFAULT_DISPATCHER;
+			else if (!strcmp(value, "stealing"))
+				options.config.dispatcher = PhysicsEngine::WORK_STEALING_DISPATCHER;
+			else
+			{
+				cerr << "Unknown dispatcher " << value << endl;
+				return false;
+			}
+		}
+		else if (!strcmp(arg, "--format"))
+			options.format = value;
+		else if (!strcmp(arg, "--out"))
+			options.output = value;
+		else if (!strcmp(arg, "--mesh-cache"))
+			options.mesh_cache = value;
+		else
+		{
+			cerr << "Unknown option " << arg << endl;
+			return false;
+		}
+
+		i++;
+	}
+
+	if ((options.format != "csv") && (options.format != "json"))
+	{
+		cerr << "Unknown format " << options.format << endl;
+		return false;
+	}
+
+	if ((options.dt <= 0.f) || options.sizes.empty())
+	{
+		cerr << "--dt has to be positive and --sizes cannot be empty" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+//build a chain, knock it over and simulate until the last domino falls or the time runs out
+BenchResult Run(PxU32 count, const BenchOptions& options)
+{
+	BenchResult result;
+	result.dominos = count;
+	result.steps = 0;
+	result.time_to_last_fall = -1.f;
+
+	//memory kept by earlier runs is part of the baseline, so every size reports only its own growth
+	double base_memory = ResidentMemory();
+	double peak_memory = base_memory;
+
+	PhysicsEngine::BenchScene* scene = new PhysicsEngine::BenchScene(count);
+	scene->Config(options.config);
+	scene->Init();
+	scene->Trigger();
+
+	PhysicsEngine::Domino* last = scene->dominos.back();
+	//the wave needs roughly 0.05 s per domino, leave plenty of room
+	PxReal max_time = (options.max_time > 0.f) ? options.max_time : 60.f + .2f * count;
+	PxU32 max_steps = (PxU32)(max_time / options.dt);
+	PxU32 idle_steps = PxMax((PxU32)(options.idle_time / options.dt), 1u);
+	PxU32 idle = 0;
+	const PxU32 memory_interval = 60;
+	chrono::duration<double, milli> step_time(0.);
+
+	while (result.steps < max_steps)
+	{
+		chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+		scene->Update(options.dt);
+		step_time += chrono::high_resolution_clock::now() - start;
+		result.steps++;
+
+		//sampled outside the timed step, often enough to catch the contact peak of the wave
+		if (!(result.steps % memory_interval))
+			peak_memory = PxMax(peak_memory, ResidentMemory());
+
+		if (PhysicsEngine::BenchScene::Fallen(last))
+		{
+			result.time_to_last_fall = result.steps * options.dt;
+			break;
+		}
+
+		//everything is asleep, the chain broke somewhere
+		if (scene->Statistics().nbActiveDynamicBodies)
+			idle = 0;
+		else if (++idle >= idle_steps)
+			break;
+	}
+
+	result.fallen = 0;
+	for (PxU32 i = 0; i < scene->dominos.size(); i++)
+	{
+		if (PhysicsEngine::BenchScene::Fallen(scene->dominos[i]))
+			result.fallen++;
+	}
+
+	result.ms_per_step = result.steps ? step_time.count() / result.steps : 0.;
+	result.memory_mb = PxMax(peak_memory, ResidentMemory()) - base_memory;
+
+	delete scene;
+
+	return result;
+}
+
+void Write(ostream& out, const vector<BenchResult>& results, const string& format)
+{
+	if (format == "json")
+	{
+		out << "[" << endl;
+		for (PxU32 i = 0; i < results.size(); i++)
+		{
+			const BenchResult& r = results[i];
+			out << "  {\"dominos\": " << r.dominos << ", \"steps\": " << r.steps << ", \"ms_per_step\": " << r.ms_per_step
+				<< ", \"memory_mb\": " << r.memory_mb << ", \"time_to_last_fall\": " << r.time_to_last_fall
+				<< ", \"fallen\": " << r.fallen << "}" << ((i + 1 < results.size()) ? "," : "") << endl;
+		}
+		out << "]" << endl;
+	}
+	else
+	{
+		out << "dominos,steps,ms_per_step,memory_mb,time_to_last_fall,fallen" << endl;
+		for (PxU32 i = 0; i < results.size(); i++)
+		{
+			const BenchResult& r = results[i];
+			out << r.dominos << "," << r.steps << "," << r.ms_per_step << "," << r.memory_mb << ","
+				<< r.time_to_last_fall << "," << r.fallen << endl;
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	BenchOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	vector<BenchResult> results;
+
+	try
+	{
+		PhysicsEngine::PxInit();
+		PhysicsEngine::MeshCache::Directory(options.mesh_cache);
+
+		for (PxU32 i = 0; i < options.sizes.size(); i++)
+		{
+			cerr << "Running " << options.sizes[i] << " dominos..." << endl;
+			results.push_back(Run(options.sizes[i], options));
+		}
+	}
+	catch (Exception* exc)
+	{
+		cerr << exc->what() << endl;
+		delete exc;
+		return 1;
+	}
+
+	if (options.output.size())
+	{
+		ofstream file(options.output.c_str());
+		if (!file)
+		{
+			cerr << "Could not open " << options.output << endl;
+			return 1;
+		}
+		Write(file, results, options.format);
+	}
+	else
+		Write(cout, results, options.format);
+
+	PhysicsEngine::PxRelease();
+
+	return 0;
+}
@@ -0,0 +1,168 @@
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include "MyPhysicsEngine.h"
+
+using namespace std;
+using namespace physx;
+
+///Options of a single headless run
+struct HeadlessOptions
+{
+	//number of simulation steps to perform
+	unsigned int steps;
+	//simulation step size
+	PxReal dt;
+	//simulated time at which the show starts (negative = never)
+	PxReal begin_show;
+	//simulated time at which the show gets ruined (negative = never)
+	PxReal ruin_show;
+	//scene configuration (worker threads)
+	PhysicsEngine::SceneConfig config;
+	//directory of cooked mesh files, empty = cook every run
+	string mesh_cache;
+
+	HeadlessOptions() : steps(6000), dt(1.f/60.f), begin_show(0.f), ruin_show(-1.f)
+	{
+		//nothing is rendered
+		config.publish_snapshots = false;
+	}
+};
+
+void PrintUsage(const char* program)
+{
+	cerr << "Usage: " << program << " [options]" << endl;
+	cerr << "    --steps N         number of simulation steps (default 6000)" << endl;
+	cerr << "    --dt SECONDS      simulation step size (default 1/60)" << endl;
+	cerr << "    --begin-show T    simulated time of beginShow, negative = never (default 0)" << endl;
+	cerr << "    --ruin-show T     simulated time of ruinShow, negative = never (default -1)" << endl;
+	cerr << "    --threads N       number of PhysX worker threads (default hardware threads - 1)" << endl;
+	cerr << "    --dispatcher NAME default or stealing (default default)" << endl;
+	cerr << "    --mesh-cache DIR  keep cooked meshes in DIR for later runs (default off)" << endl;
+}
+
+//parse the command line, returns false if the program should exit
+bool ParseOptions(int argc, char* argv[], HeadlessOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = (i + 1 < argc) ? argv[i + 1] : 0;
+
+		if (!strcmp(arg, "--help") || !strcmp(arg, "-h"))
+			return false;
+
+		if (!value)
+		{
+			cerr << "Missing value for " << arg << endl;
+			return false;
+		}
+
+		if (!strcmp(arg, "--steps"))
+			options.steps = (unsigned int)strtoul(value, 0, 10);
+		else if (!strcmp(arg, "--dt"))
+			options.dt = (PxReal)atof(value);
+		else if (!strcmp(arg, "--begin-show"))
+			options.begin_show = (PxReal)atof(value);
+		else if (!strcmp(arg, "--ruin-show"))
+			options.ruin_show = (PxReal)atof(value);
+		else if (!strcmp(arg, "--threads"))
+			options.config.num_threads = (PxU32)strtoul(value, 0, 10);
+		else if (!strcmp(arg, "--dispatcher"))
+		{
+			if (!strcmp(value, "default"))
+				options.config.dispatcher = PhysicsEngine::DEFAULT_DISPATCHER;
+			else if (!strcmp(value, "stealing"))
+				options.config.dispatcher = PhysicsEngine::WORK_STEALING_DISPATCHER;
+			else
+			{
+				cerr << "Unknown dispatcher " << value << endl;
+				return false;
+			}
+		}
+		else if (!strcmp(arg, "--mesh-cache"))
+			options.mesh_cache = value;
+		else
+		{
+			cerr << "Unknown option " << arg << endl;
+			return false;
+		}
+
+		i++;
+	}
+
+	if (options.dt <= 0.f)
+	{
+		cerr << "--dt has to be positive" << endl;
+		return false;
+	}
+
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	HeadlessOptions options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage(argv[0]);
+		return 1;
+	}
+
+	PhysicsEngine::MyScene* scene = 0;
+
+	try
+	{
+		PhysicsEngine::PxInit();
+		PhysicsEngine::MeshCache::Directory(options.mesh_cache);
+		scene = new PhysicsEngine::MyScene();
+		scene->Config(options.config);
+		scene->Init();
+	}
+	catch (Exception* exc)
+	{
+		cerr << exc->what() << endl;
+		delete exc;
+		return 1;
+	}
+
+	bool show_begun = false;
+	bool show_ruined = false;
+
+	chrono::high_resolution_clock::time_point start = chrono::high_resolution_clock::now();
+
+	for (unsigned int i = 0; i < options.steps; i++)
+	{
+		PxReal sim_time = i * options.dt;
+
+		if (!show_begun && (options.begin_show >= 0.f) && (sim_time >= options.begin_show))
+		{
+			scene->beginShow();
+			show_begun = true;
+		}
+
+		if (!show_ruined && (options.ruin_show >= 0.f) && (sim_time >= options.ruin_show))
+		{
+			scene->ruinShow();
+			show_ruined = true;
+		}
+
+		scene->Update(options.dt);
+	}
+
+	chrono::duration<double> elapsed = chrono::high_resolution_clock::now() - start;
+
+	cout << "dispatcher:     " << (options.config.dispatcher == PhysicsEngine::WORK_STEALING_DISPATCHER ? "stealing" : "default") << endl;
+	cout << "threads:        " << options.config.num_threads << endl;
+	cout << "steps:          " << options.steps << endl;
+	cout << "simulated time: " << options.steps * options.dt << " s" << endl;
+	cout << "wall time:      " << elapsed.count() << " s" << endl;
+	if (elapsed.count() > 0.)
+		cout << "steps/sec:      " << options.steps / elapsed.count() << endl;
+
+	delete scene;
+	PhysicsEngine::PxRelease();
+
+	return 0;
+}